@@ -0,0 +1,390 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Data;
+using System.Globalization;
+using System.Runtime.InteropServices;
+#if CODECONTRACTS
+using System.Diagnostics.Contracts;
+#endif
+
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
+
+namespace Pqsql
+{
+	/// <summary>
+	/// executes the single statement of a PqsqlCommand once for each of many parameter rows.
+	/// The statement is parsed and prepared once, each row is encoded into the reusable parameter
+	/// buffer of the command and all executions are sent in libpq pipeline mode (libpq 14 or later).
+	/// Older libpq versions execute the rows one after the other.
+	/// </summary>
+	public sealed class PqsqlBatch
+	{
+		// ask the server for the results of the sent rows after this many rows
+		private const int FlushRows = 1000;
+
+		private readonly PqsqlCommand mCmd;
+
+		// parameter values for the Input and InputOutput parameters of mCmd.Parameters
+		private readonly List<object[]> mRows = new List<object[]>();
+
+		// Summary:
+		//     Initializes a new batch for the statement of command. command.Parameters
+		//     define names and types of the parameters, their values are taken from the
+		//     rows added with Add().
+		public PqsqlBatch(PqsqlCommand command)
+		{
+#if CODECONTRACTS
+			Contract.Requires<ArgumentNullException>(command != null);
+#else
+			if (command == null)
+				throw new ArgumentNullException(nameof(command));
+#endif
+
+			mCmd = command;
+		}
+
+		// Summary:
+		//     Gets the command executed by this batch.
+		public PqsqlCommand Command
+		{
+			get { return mCmd; }
+		}
+
+		// Summary:
+		//     Gets the number of parameter rows in this batch.
+		public int Count
+		{
+			get { return mRows.Count; }
+		}
+
+		// Summary:
+		//     Adds a parameter row. values are assigned in order to the Input and
+		//     InputOutput parameters of Command.Parameters.
+		public void Add(params object[] values)
+		{
+			if (values == null)
+				throw new ArgumentNullException(nameof(values));
+
+			mRows.Add(values);
+		}
+
+		// Summary:
+		//     Removes all parameter rows.
+		public void Clear()
+		{
+			mRows.Clear();
+		}
+
+		// Summary:
+		//     Executes the statement of Command for each parameter row. In pipeline mode
+		//     (libpq 14 or later) all executions run in one implicit transaction unless an
+		//     explicit transaction is active, an error in one row aborts the remaining rows.
+		//     Without pipeline mode each row is a transaction on its own unless an explicit
+		//     transaction is active, an error in one row stops the batch, but the rows
+		//     before have been committed already.
+		//
+		// Returns:
+		//     The number of rows affected by the execution of each parameter row, as
+		//     returned by PqsqlCommand.ExecuteNonQuery, or -1 for rows that failed.
+		public int[] ExecuteNonQuery()
+		{
+			int[] affected = new int[mRows.Count];
+
+			if (mRows.Count == 0)
+				return affected;
+
+			string[] statements = mCmd.BuildStatements();
+
+			if (statements.Length != 1)
+				throw new InvalidOperationException("PqsqlBatch requires a command with a single statement");
+
+			string stmt = statements[0];
+			byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
+
+			// the parameters receiving the row values
+			List<PqsqlParameter> parameters = new List<PqsqlParameter>();
+			foreach (PqsqlParameter p in mCmd.Parameters)
+			{
+				ParameterDirection direction = p.Direction;
+				if (direction == ParameterDirection.Input || direction == ParameterDirection.InputOutput)
+				{
+					parameters.Add(p);
+				}
+			}
+
+			object[] saved = new object[parameters.Count];
+			for (int j = 0; j < saved.Length; j++)
+			{
+				saved[j] = parameters[j].Value;
+			}
+
+			mCmd.CheckOpen();
+
+			PqsqlConnection conn = mCmd.Connection;
+#if CODECONTRACTS
+			Contract.Assert(conn != null);
+#endif
+
+			if (mCmd.CommandTimeout > 0)
+			{
+				conn.SetSessionParameter(PqsqlClientConfiguration.StatementTimeout, mCmd.CommandTimeout);
+			}
+
+			try
+			{
+				Execute(conn, stmt, utf8query, parameters, affected);
+			}
+			finally
+			{
+				// restore parameter values of mCmd
+				for (int j = 0; j < saved.Length; j++)
+				{
+					parameters[j].Value = saved[j];
+				}
+			}
+
+			return affected;
+		}
+
+		// encode row i into the parameter buffer of mCmd
+		private PqsqlParameterBuffer SetRow(int i, List<PqsqlParameter> parameters)
+		{
+			object[] row = mRows[i];
+
+			if (row.Length != parameters.Count)
+			{
+				string msg = string.Format(CultureInfo.InvariantCulture, "Parameter row {0} has {1} values, but the command expects {2}", i, row.Length, parameters.Count);
+				throw new ArgumentException(msg);
+			}
+
+			for (int j = 0; j < row.Length; j++)
+			{
+				parameters[j].Value = row[j];
+			}
+
+			return mCmd.GetParameterBuffer();
+		}
+
+		private void Execute(PqsqlConnection conn, string stmt, byte[] utf8query, List<PqsqlParameter> parameters, int[] affected)
+		{
+			IntPtr pgconn = conn.PGConnection;
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			// prepare the statement with the parameter types of the first row
+			num_param = SetRow(0, parameters).GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+			int[] types = new int[num_param];
+			if (num_param > 0)
+			{
+				Marshal.Copy(ptyps, types, 0, num_param);
+			}
+
+			byte[] name;
+			if (!conn.StatementCache.TryGetStatement(pgconn, stmt, utf8query, num_param, ptyps, PqsqlPreparedStatementCache.PrepareMode.Batch, out name))
+			{
+				throw new PqsqlException("Could not prepare statement «" + stmt + "»: " + conn.GetErrorMessage());
+			}
+
+			bool pipelined = PqsqlConnection.PipelineModeSupported && PqsqlWrapper.PQenterPipelineMode(pgconn) != 0;
+
+			// in pipeline mode the rows are queued without blocking on a full socket buffer, see Flush()
+			if (pipelined && PqsqlWrapper.PQsetnonblocking(pgconn, 1) != 0)
+			{
+				PqsqlWrapper.PQexitPipelineMode(pgconn);
+				throw new PqsqlException(conn.GetErrorMessage());
+			}
+
+			PqsqlException err = null;
+			int sent = 0;
+			int received = 0;
+			bool synced = false;
+
+			try
+			{
+				for (int i = 0; i < affected.Length && err == null; i++)
+				{
+					if (i > 0)
+					{
+						num_param = SetRow(i, parameters).GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+					}
+
+					if (!Send(pgconn, utf8query, SameTypes(types, num_param, ptyps) ? name : null, num_param, ptyps, pvals, plens, pfrms))
+					{
+						err = new PqsqlException(conn.GetErrorMessage());
+						break;
+					}
+
+					sent++;
+
+					if (!pipelined)
+					{
+						err = Receive(conn, affected, ref received, sent, true);
+						continue;
+					}
+
+					// let the server send the results of the rows sent so far
+					if (sent % FlushRows == 0 && PqsqlWrapper.PQsendFlushRequest(pgconn) == 0)
+					{
+						err = new PqsqlException(conn.GetErrorMessage());
+						break;
+					}
+
+					err = Flush(conn, affected, ref received, sent);
+				}
+
+				if (pipelined)
+				{
+					synced = true;
+
+					if (PqsqlWrapper.PQpipelineSync(pgconn) == 0)
+					{
+						err = err ?? new PqsqlException(conn.GetErrorMessage());
+					}
+					else
+					{
+						PqsqlException e = Flush(conn, affected, ref received, sent) ?? Receive(conn, affected, ref received, sent, true);
+						err = err ?? e;
+					}
+				}
+			}
+			finally
+			{
+				if (pipelined)
+				{
+					if (!synced && PqsqlWrapper.PQpipelineSync(pgconn) != 0) // we bailed out with an exception
+					{
+						Flush(conn, affected, ref received, sent);
+					}
+
+					PqsqlWrapper.PQsetnonblocking(pgconn, 0);
+					PqsqlUtils.FinishPipeline(pgconn, false);
+				}
+			}
+
+			if (err != null)
+			{
+				throw err;
+			}
+		}
+
+		// true if the num_param parameter types in ptyps are the prepared types
+		private static bool SameTypes(int[] types, int num_param, IntPtr ptyps)
+		{
+			if (num_param != types.Length)
+				return false;
+
+			for (int j = 0; j < num_param; j++)
+			{
+				if (Marshal.ReadInt32(ptyps, j * sizeof(int)) != types[j])
+					return false;
+			}
+
+			return true;
+		}
+
+		// send the current row with PQsendQueryPrepared if name is set, otherwise with PQsendQueryParams
+		private static bool Send(IntPtr pgconn, byte[] utf8query, byte[] name, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms)
+		{
+			unsafe
+			{
+				if (name != null)
+				{
+					fixed (byte* pn = name)
+					{
+						return PqsqlWrapper.PQsendQueryPrepared(pgconn, pn, num_param, pvals, plens, pfrms, 1) != 0;
+					}
+				}
+
+				fixed (byte* pq = utf8query)
+				{
+					return PqsqlWrapper.PQsendQueryParams(pgconn, pq, num_param, ptyps, pvals, plens, pfrms, 1) != 0;
+				}
+			}
+		}
+
+		// send the queued rows in non-blocking mode. While the socket takes no more output, the
+		// server might block on sending us results, so we read the results of the sent rows
+		// meanwhile. Returns the error of the first failed row or null
+		private static PqsqlException Flush(PqsqlConnection conn, int[] affected, ref int received, int sent)
+		{
+			IntPtr pgconn = conn.PGConnection;
+			PqsqlException err = null;
+			int f;
+
+			while ((f = PqsqlWrapper.PQflush(pgconn)) == 1)
+			{
+				int ready = PqsqlBinaryFormat.pqsw_wait(pgconn, PqsqlBinaryFormat.PQSW_READ | PqsqlBinaryFormat.PQSW_WRITE, -1);
+
+				if (ready < 0)
+					return err ?? new PqsqlException("Could not wait for the socket of the connection", (int) PqsqlState.CONNECTION_FAILURE);
+
+				if ((ready & PqsqlBinaryFormat.PQSW_READ) != 0)
+				{
+					if (PqsqlWrapper.PQconsumeInput(pgconn) == 0)
+						return err ?? new PqsqlException(conn.GetErrorMessage());
+
+					PqsqlException e = Receive(conn, affected, ref received, sent, false);
+					err = err ?? e;
+				}
+			}
+
+			if (f < 0)
+				return err ?? new PqsqlException(conn.GetErrorMessage());
+
+			return err;
+		}
+
+		// read the results of the rows received..sent-1 into affected, returns the error of the first failed row or null.
+		// Without wait we stop at the first result libpq has not received completely yet
+		private static PqsqlException Receive(PqsqlConnection conn, int[] affected, ref int received, int sent, bool wait)
+		{
+			IntPtr pgconn = conn.PGConnection;
+			PqsqlException err = null;
+
+			while (received < sent && (wait || PqsqlWrapper.PQisBusy(pgconn) == 0))
+			{
+				IntPtr res = PqsqlWrapper.PQgetResult(pgconn);
+
+				if (res == IntPtr.Zero)
+				{
+					// the NULL result ends the results of row received
+					received++;
+					continue;
+				}
+
+				ExecStatusType s = PqsqlWrapper.PQresultStatus(res);
+
+				switch (s)
+				{
+					case ExecStatusType.PGRES_COMMAND_OK:
+					case ExecStatusType.PGRES_TUPLES_OK:
+						affected[received] = PqsqlUtils.GetCmdTuples(res);
+						conn.TrackSessionState(res);
+						break;
+
+					case ExecStatusType.PGRES_PIPELINE_ABORTED:
+						affected[received] = -1;
+						break;
+
+					default:
+						affected[received] = -1;
+						if (err == null)
+						{
+							string msg = PqsqlUtils.GetResultErrorMessage(res);
+							err = new PqsqlException(string.Format(CultureInfo.InvariantCulture, "Could not execute parameter row {0}: {1}", received, msg), res);
+						}
+						break;
+				}
+
+				PqsqlWrapper.PQclear(res);
+			}
+
+			return err;
+		}
+	}
+}
@@ -167,6 +167,29 @@ namespace Pqsql
 
 			#endregion
 
+			#region numeric and decimal conversions
+
+			private const int DecimalSignMask = unchecked((int) 0x80000000);
+			private const int DecimalScaleShift = 16;
+
+			public static void GetDecimal(decimal d, out uint lo, out uint mid, out uint hi, out int scale, out int sign)
+			{
+				// lo, mid, hi, and flags of the 96-bit mantissa, independent of the in-memory layout of decimal
+				int[] bits = decimal.GetBits(d);
+				lo = (uint) bits[0];
+				mid = (uint) bits[1];
+				hi = (uint) bits[2];
+				scale = (bits[3] >> DecimalScaleShift) & 0xFF;
+				sign = (bits[3] & DecimalSignMask) != 0 ? 1 : 0;
+			}
+
+			public static decimal GetDecimal(uint lo, uint mid, uint hi, int scale, int sign)
+			{
+				return new decimal((int) lo, (int) mid, (int) hi, sign != 0, (byte) scale);
+			}
+
+			#endregion
+
 			#region interval / time / timetz and TimeSpan conversions
 
 			public static void GetInterval(TimeSpan ts, out long offset, out int day, out int month)
@@ -232,6 +255,23 @@ namespace Pqsql
 				return new DateTime(ticks);
 			}
 
+			// encode dt as 64bit timestamp, inverse of GetDateTimeFromTimestamp
+			public static long GetTimestampFromDateTime(DateTime dt)
+			{
+				long sec;
+				int usec;
+				GetTimestamp(dt, out sec, out usec);
+
+				switch (sec)
+				{
+					case long.MinValue:
+					case long.MaxValue:
+						return sec;
+					default:
+						return (sec - PostgresEpochDate) * PostgresMega + usec;
+				}
+			}
+
 			public static long GetTicksFromTime(int hour, int min, int sec, int fsec)
 			{
 				return hour * TimeSpan.TicksPerHour +
@@ -352,6 +392,9 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern void pqpb_reset(IntPtr pb);
 
+			[DllImport("libpqbinfmt")]
+			public static extern int pqpb_reserve(IntPtr pb, UIntPtr n, UIntPtr payload_bytes);
+
 			[DllImport("libpqbinfmt")]
 			public static extern int pqpb_get_num(IntPtr pb);
 
@@ -421,6 +464,9 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_add_numeric(IntPtr pb, double d);
 
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_decimal(IntPtr pb, uint lo, uint mid, uint hi, int scale, int sign);
+
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_add_interval(IntPtr pbb, long offset, int day, int month);
 
@@ -439,6 +485,26 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_add_array(IntPtr pbb, IntPtr a, uint oid);
 
+			// encode n items of values as one-dimensional array, item i is NULL iff bit i of nullmap is set (nullmap may be null)
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_int2_array(IntPtr pbb, short* values, int n, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_int4_array(IntPtr pbb, int* values, int n, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_int8_array(IntPtr pbb, long* values, int n, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_float4_array(IntPtr pbb, float* values, int n, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_float8_array(IntPtr pbb, double* values, int n, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_add_oid_array(IntPtr pbb, uint* values, int n, byte* nullmap);
+
 			#endregion
 
 			#region encode datatype to binary PQExpBuffer
@@ -481,6 +547,9 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_set_numeric(IntPtr s, double d);
 
+			[DllImport("libpqbinfmt")]
+			public static extern void pqbf_set_decimal(IntPtr s, uint lo, uint mid, uint hi, int scale, int sign);
+
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_set_interval(IntPtr s, long offset, int day, int month);
 
@@ -550,6 +619,10 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern double pqbf_get_numeric(IntPtr p, int typmod);
 
+			// returns 1 on success, 0 for NaN / +-Infinity, -1 if the value does not fit in a decimal
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_get_decimal(IntPtr p, out uint lo, out uint mid, out uint hi, out int scale, out int sign);
+
 			[DllImport("libpqbinfmt")]
 			public static extern void pqbf_get_bytea(IntPtr p, sbyte* buf, ulong len);
 
@@ -574,12 +647,58 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern IntPtr pqbf_get_array_value(IntPtr p, int* itemlen);
 
+			// decodes n non-NULL fixed-length items into values, returns n or -1 on NULL items or length mismatch
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_get_array_values(IntPtr p, int n, int itemlen, IntPtr values);
+
+			#endregion
+
+			#region decode whole column of PGresult
+
+			// the following functions decode up to nrows values of column col starting at row into values,
+			// bit i of nullmap is set iff row + i is NULL (nullmap may be null)
+			// return the number of decoded rows or -1 if col does not have the expected datatype length
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_bool(IntPtr res, int col, int row, int nrows, byte* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_int2(IntPtr res, int col, int row, int nrows, short* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_int4(IntPtr res, int col, int row, int nrows, int* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_int8(IntPtr res, int col, int row, int nrows, long* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_float4(IntPtr res, int col, int row, int nrows, float* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_float8(IntPtr res, int col, int row, int nrows, double* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_timestamp(IntPtr res, int col, int row, int nrows, long* values, byte* nullmap);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqbf_decode_column_date(IntPtr res, int col, int row, int nrows, int* values, byte* nullmap);
+
 			#endregion
 
 			#region interface to pqcopy_buffer
 
+			// column descriptor for pqcb_put_rows()
+			[StructLayout(LayoutKind.Sequential)]
+			public struct pqcopy_column
+			{
+				public uint oid;
+				public void* values;
+				public int* lens;
+				public byte* nullmap;
+			}
+
 			[DllImport("libpqbinfmt")]
-			public static extern IntPtr pqcb_create(IntPtr conn, int num_cols);
+			public static extern IntPtr pqcb_create(IntPtr conn, int num_cols, UIntPtr bufsiz);
 
 			[DllImport("libpqbinfmt")]
 			public static extern void pqcb_free(IntPtr pc);
@@ -590,10 +709,66 @@ namespace Pqsql
 			[DllImport("libpqbinfmt")]
 			public static extern int pqcb_put_col(IntPtr pc, sbyte* val, uint len);
 
+			[DllImport("libpqbinfmt")]
+			public static extern int pqcb_put_rows(IntPtr pc, pqcopy_column* cols, int ncols, int nrows);
+
 			[DllImport("libpqbinfmt")]
 			public static extern int pqcb_put_end(IntPtr pc);
 
 			#endregion
+
+			#region interface to pqcopy_reader
+
+			// pqcr_get_rows() error codes
+			public const int PQCR_ERROR = -1;
+			public const int PQCR_CONN = -2;
+			public const int PQCR_TOOSMALL = -3;
+
+			// column vector for pqcr_get_rows()
+			[StructLayout(LayoutKind.Sequential)]
+			public struct pqcopy_vector
+			{
+				public uint oid;
+				public void* values;
+				public int* lens;
+				public byte* nullmap;
+				public UIntPtr cap;
+				public UIntPtr used;
+			}
+
+			[DllImport("libpqbinfmt")]
+			public static extern IntPtr pqcr_create(IntPtr conn, int num_cols, int header_received);
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqcr_free(IntPtr pr);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqcr_get_rows(IntPtr pr, pqcopy_vector* cols, int ncols, int nrows);
+
+			#endregion
+
+			#region interface to pqwait
+
+			// pqsw_wait() events
+			public const int PQSW_READ = 1;
+			public const int PQSW_WRITE = 2;
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqsw_wait(IntPtr conn, int events, int timeout);
+
+			[DllImport("libpqbinfmt")]
+			public static extern IntPtr pqsw_create();
+
+			[DllImport("libpqbinfmt")]
+			public static extern void pqsw_free(IntPtr ws);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqsw_add(IntPtr ws, IntPtr conn, int events, long token);
+
+			[DllImport("libpqbinfmt")]
+			public static extern int pqsw_wait_any(IntPtr ws, long* tokens, int max, int timeout);
+
+			#endregion
 		}
 	}
 }
@@ -7,6 +7,8 @@ using System.Data;
 using System.Globalization;
 using System.Linq;
 using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
 #if CODECONTRACTS
 using System.Diagnostics.Contracts;
 #endif
@@ -35,10 +37,19 @@ namespace Pqsql
 
 		private readonly PqsqlParameterCollection mParams;
 
+		// parameter buffer reused for each execution of this command
+		private PqsqlParameterBuffer mParamBuffer;
+
 		private PqsqlTransaction mTransaction;
 
 		private UpdateRowSource mUpdateRowSource = UpdateRowSource.Both;
 
+		// execute statements as server-side prepared statements after Prepare()
+		private bool mPrepared;
+
+		// read each result as one fully materialized PGresult instead of row by row
+		private bool mBufferedResults;
+
 #if CODECONTRACTS
 		[ContractInvariantMethod]
 		private void ClassInvariant()
@@ -92,6 +103,13 @@ namespace Pqsql
 				mConn = null;
 			}
 
+			// release native parameter buffer
+			if (mParamBuffer != null)
+			{
+				mParamBuffer.Dispose();
+				mParamBuffer = null;
+			}
+
 			base.Dispose(disposing);
 			mDisposed = true;
 		}
@@ -252,6 +270,26 @@ namespace Pqsql
 			}
 		}
 
+		// Summary:
+		//     Returns the parameter buffer of this command filled with the current
+		//     values of Parameters. The buffer is created on first use and reused for
+		//     all further executions of this command.
+		internal PqsqlParameterBuffer GetParameterBuffer()
+		{
+			if (mParamBuffer == null)
+			{
+				mParamBuffer = new PqsqlParameterBuffer();
+			}
+			else
+			{
+				mParamBuffer.Clear();
+			}
+
+			mParamBuffer.AddParameterCollection(mParams);
+
+			return mParamBuffer;
+		}
+
 		//
 		// Summary:
 		//     Gets or sets the System.Data.Common.DbTransaction within which this System.Data.Common.DbCommand
@@ -405,8 +443,77 @@ namespace Pqsql
 		//     The number of rows affected.
 		public override int ExecuteNonQuery()
 		{
-			PqsqlDataReader r = ExecuteReader(CommandBehavior.Default);
+			string[] statements = BuildStatements();
+
+			SetupExecution(statements, CommandBehavior.Default);
+
+			return ExecuteNonQuery(statements);
+		}
+
+		//
+		// Summary:
+		//     Executes a SQL statement against a connection object. Commands of connections
+		//     with multiplexing wait asynchronously for their result, all other commands
+		//     are executed like ExecuteNonQuery().
+		//
+		// Returns:
+		//     The number of rows affected.
+		public override async Task<int> ExecuteNonQueryAsync(CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			string[] statements = BuildStatements();
+
+			SetupExecution(statements, CommandBehavior.Default);
+
+			if (!CanMultiplex(statements))
+			{
+				return ExecuteNonQuery(statements);
+			}
+
+			IntPtr res = await ExecuteMultiplexedAsync(statements[0], cancellationToken).ConfigureAwait(false);
+			int n = PqsqlUtils.GetCmdTuples(res);
+			PqsqlWrapper.PQclear(res);
+			return n;
+		}
+
+		// execute statements and accumulate RecordsAffected, SetupExecution() must have been called before
+		private int ExecuteNonQuery(string[] statements)
+		{
+			if (CanMultiplex(statements))
+			{
+				IntPtr res = ExecuteMultiplexed(statements[0]);
+				int n = PqsqlUtils.GetCmdTuples(res);
+				PqsqlWrapper.PQclear(res);
+				return n;
+			}
+
+			if (!CanExecuteDirect(statements))
+			{
+				return ExecuteNonQuery(ExecuteReader(statements));
+			}
 
+			int ra = -1;
+
+			foreach (string stmt in statements)
+			{
+				IntPtr res = ExecuteDirect(stmt);
+				int n = PqsqlUtils.GetCmdTuples(res);
+				PqsqlWrapper.PQclear(res);
+
+				// accumulate positive RecordsAffected for each UPDATE / DELETE / INSERT / CREATE * / ... statement
+				if (n >= 0)
+				{
+					ra = ra < 0 ? n : ra + n;
+				}
+			}
+
+			return ra;
+		}
+
+		// execute statements with a PqsqlDataReader r and accumulate RecordsAffected
+		private int ExecuteNonQuery(PqsqlDataReader r)
+		{
 			// fill OUT and INOUT parameters with result tuple from the first row
 			if (CommandType == CommandType.StoredProcedure)
 			{
@@ -496,29 +603,88 @@ namespace Pqsql
 			Contract.Ensures(Contract.Result<PqsqlDataReader>() != null);
 #endif
 
-			string[] statements;
-			switch(CommandType)
-			{
-				case CommandType.Text:
-					statements = ParseStatements().ToArray();
-					break;
+			string[] statements = BuildStatements();
 
-				case CommandType.StoredProcedure:
-					statements = BuildStoredProcStatement();
-					break;
+			SetupExecution(statements, behavior);
 
-				case CommandType.TableDirect:
-					statements = BuildTableStatement();
-					break;
+			return ExecuteReader(statements);
+		}
 
-				default:
-					throw new InvalidEnumArgumentException("unknown CommandType");
-			}
+		//
+		// Summary:
+		//     Asynchronously executes the System.Data.Common.DbCommand.CommandText against the
+		//     System.Data.Common.DbCommand.Connection, and returns an System.Data.Common.DbDataReader.
+		//     No thread is blocked while the server executes the first statement, but
+		//     preparing it waits synchronously, see PqsqlDataReader.NextResultAsync.
+		//
+		// Returns:
+		//     A task representing the asynchronous operation.
+		public new Task<PqsqlDataReader> ExecuteReaderAsync()
+		{
+			return ExecuteReaderAsync(CommandBehavior.Default, CancellationToken.None);
+		}
+
+		public new Task<PqsqlDataReader> ExecuteReaderAsync(CancellationToken cancellationToken)
+		{
+			return ExecuteReaderAsync(CommandBehavior.Default, cancellationToken);
+		}
+
+		public new Task<PqsqlDataReader> ExecuteReaderAsync(CommandBehavior behavior)
+		{
+			return ExecuteReaderAsync(behavior, CancellationToken.None);
+		}
+
+		public new async Task<PqsqlDataReader> ExecuteReaderAsync(CommandBehavior behavior, CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			string[] statements = BuildStatements();
 
 #if CODECONTRACTS
-			Contract.Assert(statements != null);
+			Contract.Assume(mConn != null);
 #endif
 
+			ConnectionState s = mConn.State;
+
+			if (s == ConnectionState.Closed || (s & ConnectionState.Broken) > 0)
+			{
+				await mConn.OpenAsync(cancellationToken).ConfigureAwait(false);
+			}
+
+			SetupExecution(statements, behavior);
+
+			PqsqlDataReader r = null;
+			PqsqlDataReader reader;
+
+			try
+			{
+				r = new PqsqlDataReader(this, mCmdBehavior, statements);
+				await r.NextResultAsync(cancellationToken).ConfigureAwait(false); // always execute first command
+
+				// swap r with reader
+				reader = r;
+				r = null;
+			}
+			finally
+			{
+				if (r != null) // only dispose PqsqlDataReader if r.NextResultAsync() throwed an exception
+				{
+					r.Close();
+					r.Dispose();
+				}
+			}
+
+			return reader;
+		}
+
+		protected override async Task<DbDataReader> ExecuteDbDataReaderAsync(CommandBehavior behavior, CancellationToken cancellationToken)
+		{
+			return await ExecuteReaderAsync(behavior, cancellationToken).ConfigureAwait(false);
+		}
+
+		// open connection, set statement_timeout and save behavior for executing statements
+		private void SetupExecution(string[] statements, CommandBehavior behavior)
+		{
 			if (statements.Length < 2)
 				behavior |= CommandBehavior.SingleResult;
 
@@ -538,13 +704,21 @@ namespace Pqsql
 
 			// save behavior
 			mCmdBehavior = behavior;
+		}
+
+		// execute statements with a new PqsqlDataReader, SetupExecution() must have been called before
+		private PqsqlDataReader ExecuteReader(string[] statements)
+		{
+#if CODECONTRACTS
+			Contract.Ensures(Contract.Result<PqsqlDataReader>() != null);
+#endif
 
 			PqsqlDataReader r = null;
 			PqsqlDataReader reader;
 
 			try
 			{
-				r = new PqsqlDataReader(this, behavior, statements);
+				r = new PqsqlDataReader(this, mCmdBehavior, statements);
 				r.NextResult(); // always execute first command
 
 				// swap r with reader
@@ -563,6 +737,29 @@ namespace Pqsql
 			return reader;
 		}
 
+		// split or build the statements of CommandText according to CommandType
+		internal string[] BuildStatements()
+		{
+#if CODECONTRACTS
+			Contract.Ensures(Contract.Result<string[]>() != null);
+#endif
+
+			switch (CommandType)
+			{
+				case CommandType.Text:
+					return ParseStatements().ToArray();
+
+				case CommandType.StoredProcedure:
+					return BuildStoredProcStatement();
+
+				case CommandType.TableDirect:
+					return BuildTableStatement();
+
+				default:
+					throw new InvalidEnumArgumentException("unknown CommandType");
+			}
+		}
+
 		private string[] BuildTableStatement()
 		{
 #if CODECONTRACTS
@@ -629,7 +826,7 @@ namespace Pqsql
 		}
 
 		// open connection if it is closed or broken
-		private void CheckOpen()
+		internal void CheckOpen()
 		{
 #if CODECONTRACTS
 			Contract.Assume(mConn != null);
@@ -652,18 +849,346 @@ namespace Pqsql
 		//     The first column of the first row in the result set.
 		public override object ExecuteScalar()
 		{
-			PqsqlDataReader r = ExecuteReader(CommandBehavior.Default);
+			string[] statements = BuildStatements();
+
+			SetupExecution(statements, CommandBehavior.Default);
+
+			return ExecuteScalar(statements);
+		}
+
+		//
+		// Summary:
+		//     Executes the query and returns the first column of the first row in the result
+		//     set returned by the query. Commands of connections with multiplexing wait
+		//     asynchronously for their result, all other commands are executed like
+		//     ExecuteScalar().
+		//
+		// Returns:
+		//     The first column of the first row in the result set.
+		public override async Task<object> ExecuteScalarAsync(CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			string[] statements = BuildStatements();
+
+			SetupExecution(statements, CommandBehavior.Default);
+
+			if (!CanMultiplex(statements))
+			{
+				return ExecuteScalar(statements);
+			}
+
+			IntPtr res = await ExecuteMultiplexedAsync(statements[0], cancellationToken).ConfigureAwait(false);
+			return GetScalar(res);
+		}
+
+		// execute the first statement and return the first column of its first row, SetupExecution() must have been called before
+		private object ExecuteScalar(string[] statements)
+		{
+			if (CanMultiplex(statements))
+			{
+				return GetScalar(ExecuteMultiplexed(statements[0]));
+			}
 
 			object o;
-			if (r.Read())
-				o = r.GetValue(0);
-			else
-				o = null;
 
-			r.Consume(); // sync protocol: consume remaining rows
+			if (!CanExecuteDirect(statements))
+			{
+				PqsqlDataReader r = ExecuteReader(statements);
+
+				if (r.Read())
+					o = r.GetValue(0);
+				else
+					o = null;
+
+				r.Close(); // sync protocol: consume remaining rows and statements
+				return o;
+			}
+
+			if (statements.Length == 0) // nothing to execute
+				return null;
+
+			// like the PqsqlDataReader above, we only execute the first statement
+			return GetScalar(ExecuteDirect(statements[0]));
+		}
+
+		// the first column of the first row of result res, res will be freed
+		private object GetScalar(IntPtr res)
+		{
+			object o;
+
+			try
+			{
+				if (PqsqlWrapper.PQresultStatus(res) != ExecStatusType.PGRES_TUPLES_OK || PqsqlWrapper.PQntuples(res) < 1 || PqsqlWrapper.PQnfields(res) < 1)
+				{
+					o = null;
+				}
+				else if (PqsqlWrapper.PQgetisnull(res, 0, 0) == 1)
+				{
+					o = DBNull.Value;
+				}
+				else
+				{
+					PqsqlDbType oid = (PqsqlDbType) PqsqlWrapper.PQftype(res, 0);
+					// unknown types are fetched with a connection of their own, mConn stays multiplexed
+					PqsqlTypeRegistry.PqsqlTypeValue tv = PqsqlTypeRegistry.GetOrAdd(oid, mConn.ConnectionString);
+
+#if CODECONTRACTS
+					Contract.Assert(tv != null);
+					Contract.Assert(tv.GetValue != null);
+#endif
+
+					o = tv.GetValue(res, 0, 0, PqsqlWrapper.PQfmod(res, 0));
+				}
+			}
+			finally
+			{
+				PqsqlWrapper.PQclear(res);
+			}
+
 			return o;
 		}
 
+		#region execute statements without PqsqlDataReader
+
+		// ExecuteScalar() and ExecuteNonQuery() read results without a PqsqlDataReader, unless
+		// stored procedures fill output parameters or the statements are sent in pipeline mode
+		private bool CanExecuteDirect(string[] statements)
+		{
+			return CommandType != CommandType.StoredProcedure && (statements.Length < 2 || !mConn.PipelineMode);
+		}
+
+		// ExecuteScalar() and ExecuteNonQuery() send single statements with the Multiplexer of the pool if the
+		// connection has not taken a connection of its own and the statement keeps the session state unchanged,
+		// SetupExecution() must have been called before
+		private bool CanMultiplex(string[] statements)
+		{
+			return statements.Length == 1 && !mPrepared && CommandType != CommandType.StoredProcedure && mConn.Multiplexed && PqsqlConnection.IsMultiplexed(statements[0]);
+		}
+
+		/// <summary>
+		/// executes stmt and reads its result at once, without single row mode
+		/// </summary>
+		/// <returns>the first result of stmt, must be freed with PQclear</returns>
+		private IntPtr ExecuteDirect(string stmt)
+		{
+			// convert query string to utf8
+			byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
+
+			if (utf8query == null || utf8query[0] == 0x0) // null or empty string
+			{
+				throw new PqsqlException("Could not execute statement «" + stmt + "»: " + mConn.GetErrorMessage());
+			}
+
+			PqsqlParameterBuffer pbuf = GetParameterBuffer();
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			num_param = pbuf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+			byte[] name;
+
+			if (!LookupStatement(stmt, utf8query, num_param, ptyps, out name) || !SendStatement(stmt, utf8query, name, num_param, ptyps, pvals, plens, pfrms))
+			{
+				throw new PqsqlException("Could not execute statement «" + stmt + "»: " + mConn.GetErrorMessage());
+			}
+
+			IntPtr conn = mConn.PGConnection;
+			IntPtr result = IntPtr.Zero;
+			IntPtr res;
+
+			// keep the first result, consume and clear the remaining results until we reach the NULL result
+			while ((res = PqsqlWrapper.PQgetResult(conn)) != IntPtr.Zero)
+			{
+				if (result != IntPtr.Zero)
+				{
+					PqsqlWrapper.PQclear(res);
+					continue;
+				}
+
+				result = res;
+
+				ExecStatusType s = PqsqlWrapper.PQresultStatus(result);
+
+				if (s == ExecStatusType.PGRES_COPY_IN || s == ExecStatusType.PGRES_COPY_OUT || s == ExecStatusType.PGRES_COPY_BOTH)
+					break; // PQgetResult() would return copy results forever
+			}
+
+			if (result == IntPtr.Zero)
+			{
+				throw new PqsqlException("Could not execute statement «" + stmt + "»: " + mConn.GetErrorMessage());
+			}
+
+			ExecStatusType status = PqsqlWrapper.PQresultStatus(result);
+
+			if (status != ExecStatusType.PGRES_COMMAND_OK && status != ExecStatusType.PGRES_TUPLES_OK)
+			{
+				PqsqlException ex = new PqsqlException(mConn.GetErrorMessage(), result);
+				PqsqlWrapper.PQclear(result);
+				throw ex;
+			}
+
+			mConn.TrackSessionState(result);
+
+			return result;
+		}
+
+		/// <summary>
+		/// sends stmt with the Multiplexer of the connection and waits for its result
+		/// </summary>
+		/// <returns>the first result of stmt, must be freed with PQclear</returns>
+		private IntPtr ExecuteMultiplexed(string stmt)
+		{
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			byte[] utf8query = GetMultiplexedQuery(stmt, out num_param, out ptyps, out pvals, out plens, out pfrms);
+
+			// the parameter buffer is copied by libpq before Execute() returns, we block on the
+			// completion of the command itself without occupying another thread for a continuation
+			Task<IntPtr> completion = mConn.Multiplexer.Execute(utf8query, num_param, ptyps, pvals, plens, pfrms);
+
+			return CheckMultiplexedResult(completion.GetAwaiter().GetResult());
+		}
+
+		/// <summary>
+		/// sends stmt with the Multiplexer of the connection and waits asynchronously for its result
+		/// </summary>
+		/// <returns>the first result of stmt, must be freed with PQclear</returns>
+		private async Task<IntPtr> ExecuteMultiplexedAsync(string stmt, CancellationToken cancellationToken)
+		{
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			byte[] utf8query = GetMultiplexedQuery(stmt, out num_param, out ptyps, out pvals, out plens, out pfrms);
+
+			// the shared connection might be taken from the pool first, so the parameter buffer
+			// is in use until ExecuteAsync() completes
+			IntPtr result = await mConn.Multiplexer.ExecuteAsync(utf8query, num_param, ptyps, pvals, plens, pfrms, cancellationToken).ConfigureAwait(false);
+
+			return CheckMultiplexedResult(result);
+		}
+
+		// the utf8 query of stmt and its parameters for the Multiplexer
+		private byte[] GetMultiplexedQuery(string stmt, out int num_param, out IntPtr ptyps, out IntPtr pvals, out IntPtr plens, out IntPtr pfrms)
+		{
+			// convert query string to utf8
+			byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
+
+			if (utf8query == null || utf8query[0] == 0x0) // null or empty string
+			{
+				throw new PqsqlException("Could not execute statement «" + stmt + "»");
+			}
+
+			num_param = GetParameterBuffer().GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+			return utf8query;
+		}
+
+		// throws if the multiplexed command failed, otherwise returns result
+		private static IntPtr CheckMultiplexedResult(IntPtr result)
+		{
+			ExecStatusType status = PqsqlWrapper.PQresultStatus(result);
+
+			if (status != ExecStatusType.PGRES_COMMAND_OK && status != ExecStatusType.PGRES_TUPLES_OK)
+			{
+				PqsqlException ex = new PqsqlException(PqsqlUtils.GetResultErrorMessage(result), result);
+				PqsqlWrapper.PQclear(result);
+				throw ex;
+			}
+
+			return result;
+		}
+
+		// look up the prepared statement name of stmt if this command is prepared or automatic preparation is on
+		internal bool LookupStatement(string stmt, byte[] utf8query, int num_param, IntPtr ptyps, out byte[] name)
+		{
+			name = null;
+
+			if (mPrepared || mConn.StatementCache.AutoPrepare)
+			{
+				// look up or create the prepared statement for stmt and the current parameter types,
+				// with automatic preparation name stays null until stmt has been executed often enough
+				PqsqlPreparedStatementCache.PrepareMode mode = mPrepared ? PqsqlPreparedStatementCache.PrepareMode.Explicit : PqsqlPreparedStatementCache.PrepareMode.Auto;
+				IntPtr conn = mConn.PGConnection;
+
+				// PQsendPrepare and DEALLOCATE wait for their results, so we send them in blocking
+				// mode even if NextResultAsync switched conn to non-blocking mode
+				bool nonblocking = PqsqlWrapper.PQisnonblocking(conn) != 0;
+
+				if (nonblocking)
+				{
+					PqsqlWrapper.PQsetnonblocking(conn, 0);
+				}
+
+				try
+				{
+					return mConn.StatementCache.TryGetStatement(conn, stmt, utf8query, num_param, ptyps, mode, out name);
+				}
+				finally
+				{
+					if (nonblocking)
+					{
+						PqsqlWrapper.PQsetnonblocking(conn, 1);
+					}
+				}
+			}
+
+			return true;
+		}
+
+		// send stmt with PQsendQueryPrepared if name is set, otherwise with PQsendQueryParams
+		internal bool SendStatement(string stmt, byte[] utf8query, byte[] name, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms)
+		{
+			IntPtr conn = mConn.PGConnection;
+
+			if (name != null)
+			{
+				unsafe
+				{
+					fixed (byte* pn = name)
+					{
+						if (PqsqlWrapper.PQsendQueryPrepared(conn, pn, num_param, pvals, plens, pfrms, 1) == 0)
+							return false;
+					}
+				}
+			}
+			else
+			{
+				unsafe
+				{
+					fixed (byte* pq = utf8query)
+					{
+						if (PqsqlWrapper.PQsendQueryParams(conn, pq, num_param, ptyps, pvals, plens, pfrms, 1) == 0)
+							return false;
+					}
+				}
+			}
+
+			if (DropsPreparedStatements(stmt))
+			{
+				mConn.StatementCache.Drop(stmt);
+			}
+
+			return true;
+		}
+
+		// DISCARD ALL and DEALLOCATE drop prepared statements of the session
+		internal static bool DropsPreparedStatements(string stmt)
+		{
+			return stmt.StartsWith("discard", StringComparison.OrdinalIgnoreCase) || stmt.StartsWith("deallocate", StringComparison.OrdinalIgnoreCase);
+		}
+
+		#endregion
+
 
 		#region parse sql statements and replace parameter names
 
@@ -857,12 +1382,66 @@ namespace Pqsql
 
 		#endregion
 
+		//
+		// Summary:
+		//     Gets a value indicating whether Prepare() has been called. Statements of prepared
+		//     commands are executed as server-side prepared statements, which are cached per
+		//     connection using statement text and parameter types.
+		public bool IsPrepared
+		{
+			get { return mPrepared; }
+		}
+
+		//
+		// Summary:
+		//     Gets or sets a value indicating whether results are read as one fully
+		//     materialized result set instead of row by row (or in chunks of Result Chunk Size
+		//     rows). This saves native calls per row for short lookups, but buffers the whole
+		//     result set in memory. ExecuteReader(CommandBehavior.SingleRow) always buffers.
+		public bool BufferedResults
+		{
+			get { return mBufferedResults; }
+			set { mBufferedResults = value; }
+		}
+
 		//
 		// Summary:
 		//     Creates a prepared (or compiled) version of the command on the data source.
 		public override void Prepare()
 		{
-			throw new NotImplementedException("Prepare() is not implemented");
+			string[] statements = BuildStatements();
+
+			CheckOpen();
+
+#if CODECONTRACTS
+			Contract.Assert(mConn != null);
+#endif
+
+			PqsqlParameterBuffer pbuf = GetParameterBuffer();
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			int num_param = pbuf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+			PqsqlPreparedStatementCache cache = mConn.StatementCache;
+
+			// prepare all statements now, parameter types changing later on will prepare new statements on execution
+			foreach (string stmt in statements)
+			{
+				byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
+
+				byte[] name;
+
+				if (!cache.TryGetStatement(mConn.PGConnection, stmt, utf8query, num_param, ptyps, PqsqlPreparedStatementCache.PrepareMode.Explicit, out name))
+				{
+					string err = mConn.GetErrorMessage();
+					throw new PqsqlException("Could not prepare statement «" + stmt + "»: " + err);
+				}
+			}
+
+			mPrepared = true;
 		}
 	}
 }
@@ -5,6 +5,8 @@ using System.ComponentModel;
 using System.Globalization;
 using System.Text;
 using System.Reflection;
+using System.Threading;
+using System.Threading.Tasks;
 #if CODECONTRACTS
 using System.Diagnostics.Contracts;
 #endif
@@ -23,6 +25,7 @@ namespace Pqsql
 	internal static class PqsqlServerParameterSetting
 	{
 		internal static readonly byte[] TimeZone = PqsqlUTF8Statement.CreateUTF8Statement("TimeZone");
+		internal static readonly byte[] ApplicationName = PqsqlUTF8Statement.CreateUTF8Statement("application_name");
 	}
 
 	// When you inherit from DbConnection, you must override the following members:
@@ -46,6 +49,26 @@ namespace Pqsql
 
 		private bool mNewConnectionString;
 
+		// server-side prepared statements of the current session of mConnection
+		private PqsqlPreparedStatementCache mStatementCache;
+
+		// connection pool of mConnectionStringBuilder, mConnection will be released to this pool
+		private PqsqlConnectionPool.ConnectionPool mPool;
+
+		// true if commands might have changed the session state of mConnection, only tracked for PqsqlSessionReset.Changed
+		private bool mSessionChanged;
+
+		// true if Open() took no connection from the pool, commands are multiplexed until mConnection is taken on first use
+		private bool mMultiplexed;
+
+		// command tags of statements which do not change the session state. SELECT is missing on
+		// purpose: it might call set_config(), pg_advisory_lock(), ..., or create a table with SELECT INTO
+		private static readonly string[] SessionNeutralCommands = { "INSERT", "UPDATE", "DELETE", "MERGE", "COPY", "BEGIN", "START TRANSACTION", "COMMIT", "ROLLBACK", "SAVEPOINT", "RELEASE", "FETCH", "MOVE", "SHOW" };
+
+		// leading keywords of statements which can be multiplexed: the session neutral commands
+		// without COPY, transaction control, and cursors, plus queries
+		private static readonly string[] MultiplexedCommands = { "INSERT", "UPDATE", "DELETE", "MERGE", "SHOW", "SELECT", "VALUES", "TABLE", "WITH" };
+
 		#endregion
 
 
@@ -113,6 +136,9 @@ namespace Pqsql
 			mStatus = ConnStatusType.CONNECTION_BAD;
 			mTransStatus = PGTransactionStatusType.PQTRANS_UNKNOWN;
 			mServerVersion = -1;
+			mStatementCache = null; // prepared statements are gone with the session
+			mSessionChanged = false;
+			mMultiplexed = false;
 		}
 
 		#endregion
@@ -120,14 +146,83 @@ namespace Pqsql
 
 		#region PGConn*
 
+		// with multiplexing, a connection is taken from the pool on first use and kept until Close()
 		internal IntPtr PGConnection
 		{
 			get
 			{
+				if (mConnection == IntPtr.Zero && mMultiplexed)
+				{
+					Pin();
+				}
 				return mConnection;
 			}
 		}
 
+		// true if commands can be sent with the Multiplexer of the pool instead of PGConnection
+		internal bool Multiplexed
+		{
+			get { return mConnection == IntPtr.Zero && mMultiplexed; }
+		}
+
+		internal PqsqlMultiplexer Multiplexer
+		{
+			get { return mPool?.Multiplexer; }
+		}
+
+		// libpq version
+		private static int mLibVersion = -1;
+
+		internal static int LibVersion
+		{
+			get
+			{
+				if (mLibVersion == -1)
+				{
+					mLibVersion = PqsqlWrapper.PQlibVersion();
+				}
+
+				return mLibVersion;
+			}
+		}
+
+		// true if libpq supports pipeline mode (libpq 14)
+		internal static bool PipelineModeSupported
+		{
+			get { return LibVersion >= 140000; }
+		}
+
+		// number of rows per result chunk requested in the connection string, 0 if libpq
+		// does not support chunked rows mode (libpq 17) and rows are fetched one by one
+		internal int ResultChunkSize
+		{
+			get
+			{
+				int chunkSize = mConnectionStringBuilder.ResultChunkSize;
+				return chunkSize > 1 && LibVersion >= 170000 ? chunkSize : 0;
+			}
+		}
+
+		// true if pipeline mode is requested in the connection string and supported by libpq
+		internal bool PipelineMode
+		{
+			get { return mConnectionStringBuilder.PipelineMode && PipelineModeSupported; }
+		}
+
+		// prepared statements of the current session, created on first use
+		internal PqsqlPreparedStatementCache StatementCache
+		{
+			get
+			{
+				if (mStatementCache == null)
+				{
+					mStatementCache = new PqsqlPreparedStatementCache(mConnectionStringBuilder.MaxAutoPrepare, mConnectionStringBuilder.AutoPrepareMinUsages);
+				}
+
+				return mStatementCache;
+			}
+		}
+
 		#endregion
 
 
@@ -367,7 +462,7 @@ namespace Pqsql
 			get
 			{
 				if (mConnection == IntPtr.Zero)
-					return ConnectionState.Closed;
+					return mMultiplexed ? ConnectionState.Open : ConnectionState.Closed;
 
 				ConnectionState s = ConnectionState.Closed; // 0
 
@@ -461,7 +556,7 @@ namespace Pqsql
 				throw new ArgumentException("isolationLevel == IsolationLevel.Chaos");
 #endif
 
-			if (mConnection == IntPtr.Zero)
+			if (mConnection == IntPtr.Zero && !mMultiplexed)
 			{
 				Open();
 			}
@@ -525,10 +620,17 @@ namespace Pqsql
 		public override void Close()
 		{
 			if (mConnection == IntPtr.Zero)
+			{
+				if (mMultiplexed)
+				{
+					Init();
+					OnStateChange(new StateChangeEventArgs(ConnectionState.Open, ConnectionState.Closed));
+				}
 				return;
+			}
 
-			// release connection to the pool for mConnectionStringBuilder
-			PqsqlConnectionPool.ReleasePGConn(mConnectionStringBuilder, mConnection);
+			// release connection and its prepared statements to the pool it has been taken from
+			PqsqlConnectionPool.ReleasePGConn(mPool, mConnection, mStatementCache, mSessionChanged);
 
 			Init(); // reset state, next Open() call might end up at a different server / db
 
@@ -584,12 +686,14 @@ namespace Pqsql
 			{
 				// close and open with current connection setting
 				PqsqlWrapper.PQreset(mConnection);
+				mStatementCache?.Clear();
+				mSessionChanged = false;
 
 				// update connection and transaction status
 				if (Status == ConnStatusType.CONNECTION_BAD || TransactionStatus != PGTransactionStatusType.PQTRANS_IDLE)
 				{
 					string err = GetErrorMessage();
-					PqsqlWrapper.PQfinish(mConnection); // force release of mConnection memory
+					PqsqlConnectionPool.DiscardPGConn(mPool, mConnection); // force release of mConnection memory
 					Init();
 					var connStr = mConnectionStringBuilder.GetConnectionStringWithObfuscatedPassword();
 					throw new PqsqlException("Could not reset connection with connection string «" + connStr + "»: " + err, (int) PqsqlState.CONNECTION_FAILURE);
@@ -597,22 +701,136 @@ namespace Pqsql
 
 				OnStateChange(new StateChangeEventArgs(ConnectionState.Closed, ConnectionState.Open));
 
-				// always set application_name, after a DISCARD ALL (usually issued by PqsqlConnectionPool / pgbouncer)
-				// the session information is gone forever, and the shared connection will drop application_name
+				// set application_name, after a DISCARD ALL (usually issued by PqsqlConnectionPool / pgbouncer)
+				// the session information is gone forever, and the shared connection might drop application_name
 				SetApplicationName();
 
 				// successfully reestablished connection
 				return;
 			}
 
-			if (mStatus != ConnStatusType.CONNECTION_BAD)
+			if (mStatus != ConnStatusType.CONNECTION_BAD || mMultiplexed)
+			{
+				Close(); // force release of mConnection memory
+			}
+
+			PqsqlConnectionPool.ConnectionPool pool = GetPool();
+
+			if (pool.Multiplexer != null)
+			{
+				OpenMultiplexed();
+				return;
+			}
+
+			// check connection pool for a connection
+			mConnection = PqsqlConnectionPool.GetPGConn(pool, out mStatementCache, out mStatus, out mTransStatus);
+
+			CompleteOpen();
+		}
+
+		//
+		// Summary:
+		//     Opens a database connection asynchronously. New connections are established
+		//     with PQconnectStartParams() and PQconnectPoll() without blocking a thread,
+		//     ConnectionTimeout limits the time until the connection is established.
+		//
+		// Parameters:
+		//   cancellationToken:
+		//     The cancellation instruction.
+		//
+		// Returns:
+		//     A task representing the asynchronous operation.
+		public override async Task OpenAsync(CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			if (mConnection != IntPtr.Zero && !mNewConnectionString)
+			{
+				Open(); // PQreset() the current connection
+				return;
+			}
+
+			if (mStatus != ConnStatusType.CONNECTION_BAD || mMultiplexed)
 			{
 				Close(); // force release of mConnection memory
 			}
 
+			PqsqlConnectionPool.ConnectionPool pool = GetPool();
+
+			if (pool.Multiplexer != null)
+			{
+				OpenMultiplexed();
+				return;
+			}
+
 			// check connection pool for a connection
-			mConnection = PqsqlConnectionPool.GetPGConn(mConnectionStringBuilder, out mStatus, out mTransStatus);
+			PqsqlConnectionPool.ConnectionInfo info = await PqsqlConnectionPool.GetPGConnAsync(pool, ConnectionTimeout, cancellationToken).ConfigureAwait(false);
+			mConnection = info.pgconn;
+			mStatementCache = info.statements;
+			mStatus = PqsqlConnectionPool.GetStatus(mConnection, out mTransStatus);
+
+			CompleteOpen();
+		}
 
+		// the pool for the current connection string, only looked up again if the connection string changed
+		private PqsqlConnectionPool.ConnectionPool GetPool()
+		{
+			string connStr = mConnectionStringBuilder.ConnectionString;
+
+			if (mPool == null || !string.Equals(mPool.ConnectionString, connStr, StringComparison.Ordinal))
+			{
+				mPool = PqsqlConnectionPool.GetPool(mConnectionStringBuilder);
+			}
+
+			return mPool;
+		}
+
+		// open without taking a connection from the pool, see PGConnection
+		private void OpenMultiplexed()
+		{
+			mMultiplexed = true;
+			mNewConnectionString = false;
+
+			OnStateChange(new StateChangeEventArgs(ConnectionState.Closed, ConnectionState.Open));
+		}
+
+		// take a connection from the pool for commands which cannot be multiplexed
+		private void Pin()
+		{
+			mConnection = PqsqlConnectionPool.GetPGConn(mPool, out mStatementCache, out mStatus, out mTransStatus);
+
+			try
+			{
+				CheckPGConn();
+			}
+			catch (PqsqlException)
+			{
+				// stay open for multiplexed commands
+				mMultiplexed = true;
+				mNewConnectionString = false;
+				throw;
+			}
+
+			SetApplicationName();
+		}
+
+		// check the connection received from PqsqlConnectionPool and finish opening it
+		private void CompleteOpen()
+		{
+			CheckPGConn();
+
+			mNewConnectionString = false;
+
+			OnStateChange(new StateChangeEventArgs(ConnectionState.Closed, ConnectionState.Open));
+
+			// set application_name, after a DISCARD ALL (usually issued by PqsqlConnectionPool / pgbouncer)
+			// the session information is gone forever, and the shared connection might drop application_name
+			SetApplicationName();
+		}
+
+		// check connection and transaction status of the connection received from PqsqlConnectionPool
+		private void CheckPGConn()
+		{
 			if (mConnection == IntPtr.Zero)
 				throw new PqsqlException("libpq: unable to allocate struct PGconn");
 
@@ -620,19 +838,11 @@ namespace Pqsql
 			if (mStatus == ConnStatusType.CONNECTION_BAD || mTransStatus != PGTransactionStatusType.PQTRANS_IDLE)
 			{
 				string err = GetErrorMessage();
-				PqsqlWrapper.PQfinish(mConnection); // force release of mConnection memory
+				PqsqlConnectionPool.DiscardPGConn(mPool, mConnection); // force release of mConnection memory
 				Init();
 				var connStr = mConnectionStringBuilder.GetConnectionStringWithObfuscatedPassword();
 				throw new PqsqlException("Could not create connection with connection string «" + connStr + "»: " + err);
 			}
-
-			mNewConnectionString = false;
-
-			OnStateChange(new StateChangeEventArgs(ConnectionState.Closed, ConnectionState.Open));
-
-			// always set application_name, after a DISCARD ALL (usually issued by PqsqlConnectionPool / pgbouncer)
-			// the session information is gone forever, and the shared connection will drop application_name
-			SetApplicationName();
 		}
 
 		// call PQexec and immediately discard PGresult struct
@@ -647,7 +857,9 @@ namespace Pqsql
 		// call PQexec
 		internal ExecStatusType Exec(byte[] stmt, out IntPtr res)
 		{
-			if (mConnection == IntPtr.Zero)
+			IntPtr conn = PGConnection;
+
+			if (conn == IntPtr.Zero)
 			{
 				res = IntPtr.Zero;
 				return ExecStatusType.PGRES_FATAL_ERROR;
@@ -657,7 +869,7 @@ namespace Pqsql
 			{
 				fixed (byte* st = stmt)
 				{
-					res = PqsqlWrapper.PQexec(mConnection, st);
+					res = PqsqlWrapper.PQexec(conn, st);
 				}
 			}
 
@@ -701,15 +913,7 @@ namespace Pqsql
 
 			if (mConnection != IntPtr.Zero)
 			{
-				unsafe
-				{
-					sbyte *b = PqsqlWrapper.PQerrorMessage(mConnection);
-
-					if (b != null)
-					{
-						msg = PqsqlUTF8Statement.CreateStringFromUTF8(new IntPtr(b));
-					}
-				}
+				msg = PqsqlUtils.GetErrorMessage(mConnection);
 			}
 
 			return msg;
@@ -723,7 +927,7 @@ namespace Pqsql
 		// executes SET parameter=value
 		internal void SetSessionParameter(string parameter, object value)
 		{
-			if (mConnection == IntPtr.Zero)
+			if (PGConnection == IntPtr.Zero)
 				throw new InvalidOperationException("cannot set session parameter on closed connection");
 
 			if (string.IsNullOrEmpty(parameter))
@@ -740,6 +944,7 @@ namespace Pqsql
 
 			byte[] stmt = PqsqlUTF8Statement.CreateUTF8Statement(sb);
 			ExecStatusType s = Exec(stmt);
+			mSessionChanged = true;
 
 			if (s != ExecStatusType.PGRES_COMMAND_OK)
 			{
@@ -749,17 +954,98 @@ namespace Pqsql
 			}
 		}
 
-		// set application_name="ApplicationName"
+		// set application_name="ApplicationName" unless the server reports that the session uses it already
 		private void SetApplicationName()
 		{
 			string app = ApplicationName;
 
-			if (!string.IsNullOrEmpty(app))
+			if (!string.IsNullOrEmpty(app) && !string.Equals(app, GetParameterStatus(PqsqlServerParameterSetting.ApplicationName), StringComparison.Ordinal))
 			{
 				SetSessionParameter(PqsqlConnectionStringBuilder.application_name, "\"" + app + "\"");
 			}
 		}
 
+		// true if stmt may run on a shared connection of the Multiplexer. All other statements, e.g.,
+		// BEGIN, SET, LISTEN, or CREATE TEMP TABLE, and queries with INTO (SELECT INTO creates a
+		// table) might change the session or transaction state and pin a connection of their own
+		internal static bool IsMultiplexed(string stmt)
+		{
+			string keyword = null;
+			int i = 0;
+
+			while (i < stmt.Length)
+			{
+				if (!char.IsLetter(stmt[i]))
+				{
+					i++;
+					continue;
+				}
+
+				int start = i;
+				while (i < stmt.Length && (char.IsLetterOrDigit(stmt[i]) || stmt[i] == '_'))
+				{
+					i++;
+				}
+
+				if (keyword == null)
+				{
+					keyword = stmt.Substring(start, i - start).ToUpperInvariant();
+
+					if (!Array.Exists(MultiplexedCommands, c => c == keyword))
+						return false;
+
+					if (keyword == "INSERT" || keyword == "MERGE")
+						return true; // INSERT INTO and MERGE INTO
+				}
+				else if (i - start == 4 && string.Compare(stmt, start, "into", 0, 4, StringComparison.OrdinalIgnoreCase) == 0)
+				{
+					return false;
+				}
+			}
+
+			return keyword != null;
+		}
+
+		// remember whether the command of result res might have changed the session state
+		internal void TrackSessionState(IntPtr res)
+		{
+			if (mSessionChanged || mPool == null || mPool.SessionReset != PqsqlSessionReset.Changed)
+				return;
+
+			if (res == IntPtr.Zero)
+				return;
+
+			switch (PqsqlWrapper.PQresultStatus(res))
+			{
+				case ExecStatusType.PGRES_COMMAND_OK:
+				case ExecStatusType.PGRES_TUPLES_OK:
+					break;
+
+				case ExecStatusType.PGRES_SINGLE_TUPLE:
+				case ExecStatusType.PGRES_TUPLES_CHUNK:
+					// the command tag follows with the last result, the rows might come from a SELECT
+					mSessionChanged = true;
+					return;
+
+				default:
+					return;
+			}
+
+			string tag;
+
+			unsafe
+			{
+				sbyte* cmd = PqsqlWrapper.PQcmdStatus(res);
+
+				if (cmd == null)
+					return;
+
+				tag = new string(cmd);
+			}
+
+			mSessionChanged = !Array.Exists(SessionNeutralCommands, c => tag.StartsWith(c, StringComparison.Ordinal));
+		}
+
 		// see https://www.postgresql.org/docs/current/static/libpq-status.html#LIBPQ-PQPARAMETERSTATUS
 		private string GetParameterStatus(byte[] param)
 		{
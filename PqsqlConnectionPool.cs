@@ -1,11 +1,15 @@
 ﻿using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
+using System.Globalization;
 #if CODECONTRACTS
 using System.Diagnostics.Contracts;
 #endif
 using System.Threading;
+using System.Threading.Tasks;
 
 using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
 
 namespace Pqsql
 {
@@ -14,29 +18,105 @@ namespace Pqsql
 		// to send when releasing a connection
 		private static readonly byte[] DiscardAllStatement = PqsqlUTF8Statement.CreateUTF8Statement("DISCARD ALL");
 
+		// DISCARD ALL without DEALLOCATE ALL and DISCARD PLANS
+		private static readonly byte[] ResetAllStatement = PqsqlUTF8Statement.CreateUTF8Statement("CLOSE ALL; SET SESSION AUTHORIZATION DEFAULT; RESET ALL; UNLISTEN *; SELECT pg_advisory_unlock_all(); DISCARD SEQUENCES; DISCARD TEMP");
+
 		// ConnectionInfo pool object
-		private class ConnectionInfo
+		internal sealed class ConnectionInfo
 		{
 			// PGConn pointer
 			public IntPtr pgconn;
-			// how often did PoolService visit this item
-			public int visited;
+			// Environment.TickCount when the connection was released to the pool
+			public int released;
+			// prepared statements of the session of pgconn, null if there are none
+			public PqsqlPreparedStatementCache statements;
+			// true if the result of the session reset sent by ReleasePGConn has not been consumed yet
+			public bool resetPending;
 		}
 
-		// maps connection strings to connection queues
-		private static readonly Dictionary<PqsqlConnectionStringBuilder, Queue<ConnectionInfo>> mPooledConns = new Dictionary<PqsqlConnectionStringBuilder, Queue<ConnectionInfo>>();
+		/// <summary>
+		/// idle connections of one connection string in a lock-free LIFO stack: the most recently
+		/// released connection (with warm server-side caches) is handed out first, and connections
+		/// at the bottom of the stack idle longest and are trimmed first. PqsqlConnection caches
+		/// its ConnectionPool, so checkouts and releases do not hash the connection string.
+		/// </summary>
+		internal sealed class ConnectionPool
+		{
+			// connection string of the pooled connections
+			public readonly string ConnectionString;
+
+			// private copy of the connection settings for creating new connections
+			public readonly PqsqlConnectionStringBuilder ConnectionStringBuilder;
+
+			// idle connections, most recently released on top
+			public readonly ConcurrentStack<ConnectionInfo> Idle = new ConcurrentStack<ConnectionInfo>();
+
+			// number of connections in Idle, ConcurrentStack.Count walks the stack
+			public int Count;
+
+			// number of connections of this pool: idle, in use, or being opened
+			public int Total;
+
+			// Replenish() keeps at least MinPoolSize connections open
+			public readonly int MinPoolSize;
+
+			// at most MaxPoolSize connections are open, further requests wait in Waiters.
+			// int.MaxValue unless max_pool_size has been set
+			public readonly int MaxPoolSize;
+
+			// requests waiting for a connection in FIFO order, guarded by lock (Waiters)
+			public readonly Queue<TaskCompletionSource<ConnectionInfo>> Waiters = new Queue<TaskCompletionSource<ConnectionInfo>>();
+
+			// number of entries in Waiters, checked without taking the lock
+			public int WaiterCount;
+
+			// PoolService closes connections idle for more than IdleLifetime msecs
+			public readonly int IdleLifetime;
+
+			// connect_timeout in seconds for connections opened in the background
+			public readonly int ConnectTimeout;
+
+			// connections released less than ValidationInterval msecs ago are reused without a round trip
+			public readonly int ValidationInterval;
+
+			// session reset of released connections
+			public readonly PqsqlSessionReset SessionReset;
+
+			// shares connections of this pool between commands of many PqsqlConnection objects, null without multiplexing
+			public readonly PqsqlMultiplexer Multiplexer;
+
+			public ConnectionPool(string connectionString)
+			{
+				ConnectionString = connectionString;
+				ConnectionStringBuilder = new PqsqlConnectionStringBuilder(connectionString);
+				ValidationInterval = ConnectionStringBuilder.ValidationInterval;
+				SessionReset = ConnectionStringBuilder.SessionReset;
+				MaxPoolSize = ConnectionStringBuilder.MaxPoolSize > 0 ? ConnectionStringBuilder.MaxPoolSize : int.MaxValue;
+				MinPoolSize = Math.Min(Math.Max(0, ConnectionStringBuilder.MinPoolSize), MaxPoolSize);
+				IdleLifetime = (int) Math.Min(Math.Max(0L, ConnectionStringBuilder.ConnectionIdleLifetime) * 1000, int.MaxValue);
+
+				int multiplexing = Math.Min(ConnectionStringBuilder.Multiplexing, MaxPoolSize);
+				if (multiplexing > 0 && PqsqlConnection.PipelineModeSupported)
+				{
+					Multiplexer = new PqsqlMultiplexer(this, multiplexing);
+				}
+
+				object timeout;
+				if (ConnectionStringBuilder.TryGetValue(PqsqlConnectionStringBuilder.connect_timeout, out timeout))
+				{
+					ConnectTimeout = Convert.ToInt32(timeout, CultureInfo.InvariantCulture);
+				}
+			}
+		}
 
-		private static readonly object mPooledConnsLock = new object();
+		// maps connection strings to connection pools
+		private static readonly ConcurrentDictionary<string, ConnectionPool> mPools = new ConcurrentDictionary<string, ConnectionPool>();
 
-		// 30 sec idle timeout
-		const int IdleTimeout = 30000;
-		// only pool connections if we have <= 50 connections in the pool
-		const int MaxQueue = 50;
-		// only cleanup connections if the oldest one had been visited more than VisitedThreshold times
-		const int VisitedThreshold = 2;
+		// run PoolService every 30 sec
+		const int ServiceInterval = 30000;
 
 		// global timer for cleaning connections
-		private static Timer mTimer = new Timer(PoolService, new List<IntPtr>(), IdleTimeout, IdleTimeout);
+		private static Timer mTimer = new Timer(PoolService, new List<IntPtr>(), ServiceInterval, ServiceInterval);
 
 #if PQSQL_DEBUG
 		private static log4net.ILog mLogger;
@@ -68,79 +148,182 @@ namespace Pqsql
 
 			List<IntPtr> closeConnections = o as List<IntPtr>;
 
-			// we assume that we run PoolService in less than IdleTimeout msecs
-			lock (mPooledConnsLock)
-			{
 #if PQSQL_DEBUG
-				mLogger.Debug("Running PoolService");
+			mLogger.Debug("Running PoolService");
 #endif
 
-				using (Dictionary<PqsqlConnectionStringBuilder, Queue<ConnectionInfo>>.Enumerator e = mPooledConns.GetEnumerator())
-				{
-					while (e.MoveNext())
-					{
-						KeyValuePair<PqsqlConnectionStringBuilder, Queue<ConnectionInfo>> item = e.Current;
-#if PQSQL_DEBUG
-					PqsqlConnectionStringBuilder csb = item.Key;
-#endif
-						Queue<ConnectionInfo> queue = item.Value;
+			int now = Environment.TickCount;
 
-						lock (queue)
-						{
-							int count = queue.Count;
+			// we assume that we run PoolService in less than ServiceInterval msecs
+			foreach (ConnectionPool pool in mPools.Values)
+			{
+				Trim(pool, now, closeConnections);
 
-#if PQSQL_DEBUG
-						mLogger.DebugFormat("ConnectionPool {0}: {1} waiting connections", csb.ConnectionString, count);
-#endif
+				// open missing connections in the background
+				Replenish(pool);
+			}
 
-							if (count == 0) continue;
+			// now close old connections
+			foreach (IntPtr conn in closeConnections)
+			{
+				PqsqlWrapper.PQfinish(conn); // close connection and release memory
+			}
 
-							int maxRelease = count/2 + 1;
+			closeConnections.Clear();
+		}
 
-							ConnectionInfo i = queue.Peek();
-#if CODECONTRACTS
-							Contract.Assume(i != null);
-#endif
-							i.visited++;
+		// move idle connections of pool exceeding MinPoolSize and IdleLifetime to closeConnections
+		private static void Trim(ConnectionPool pool, int now, List<IntPtr> closeConnections)
+		{
+			// cheap check of the bottom of the stack before we take all idle connections
+			ConnectionInfo[] idle = pool.Idle.ToArray();
+			int count = idle.Length;
 
 #if PQSQL_DEBUG
-						if (i.visited <= VisitedThreshold)
-						{
-							mLogger.DebugFormat("ConnectionPool {0}: {1} visits", csb.ConnectionString, i.visited);
-						}
+			mLogger.DebugFormat("ConnectionPool {0}: {1} waiting connections", pool.ConnectionString, count);
 #endif
 
-							if (i.visited > VisitedThreshold)
-							{
+			if (count == 0 || !IsExpired(pool, idle[count - 1], now) || Volatile.Read(ref pool.Total) <= pool.MinPoolSize)
+				return;
+
+			// take all idle connections, top of the stack first
+			count = pool.Idle.TryPopRange(idle);
+
+			int keep = count;
+			int maxRelease = Math.Min(count/2 + 1, Volatile.Read(ref pool.Total) - pool.MinPoolSize);
+
+			// clean at most maxRelease connections from the bottom of the stack
+			while (keep > 0 && maxRelease > 0 && IsExpired(pool, idle[keep - 1], now))
+			{
+				keep--;
+				maxRelease--;
+				closeConnections.Add(idle[keep].pgconn); // close connections outside of the pool
+			}
+
 #if PQSQL_DEBUG
-							mLogger.DebugFormat("ConnectionPool {0}: visit threshold {1} reached, releasing {2} connections", csb.ConnectionString, i.visited, maxRelease);
+			mLogger.DebugFormat("ConnectionPool {0}: releasing {1} connections", pool.ConnectionString, count - keep);
 #endif
-								while (maxRelease > 0)
-								{
-									// clean maxRelease connections
-									i = queue.Dequeue();
-#if CODECONTRACTS
-									Contract.Assume(i != null);
-#endif
-									closeConnections.Add(i.pgconn); // close connections outside of queue lock
-									maxRelease--;
-								}
-							}
-						}
-					}
+
+			Interlocked.Add(ref pool.Count, keep - count);
+
+			if (keep > 0)
+			{
+				// PushRange puts the last item on top
+				Array.Reverse(idle, 0, keep);
+				pool.Idle.PushRange(idle, 0, keep);
+			}
+
+			// waiters enqueued while we held the idle connections get the connections we keep
+			ConnectionInfo info;
+			while (Volatile.Read(ref pool.WaiterCount) > 0 && (info = TakePGConn(pool)) != null)
+			{
+				Return(pool, info);
+			}
+
+			// hand the slots of the closed connections to waiters or free them
+			for (int i = keep; i < count; i++)
+			{
+				Return(pool, null);
+			}
+		}
+
+		// true if info has been idle for more than the idle lifetime of pool
+		private static bool IsExpired(ConnectionPool pool, ConnectionInfo info, int now)
+		{
+			return unchecked(now - info.released) > pool.IdleLifetime;
+		}
+
+		// open connections in the background until pool has MinPoolSize connections
+		private static void Replenish(ConnectionPool pool)
+		{
+			int total;
+
+			while ((total = Volatile.Read(ref pool.Total)) < pool.MinPoolSize)
+			{
+				if (Interlocked.CompareExchange(ref pool.Total, total + 1, total) == total)
+				{
+					// PQconnectStartParams might block while resolving host names
+					Task.Run(() => OpenIdleConnectionAsync(pool));
 				}
 			}
+		}
 
-			// now close old connections
-			foreach (IntPtr conn in closeConnections)
+		// open a new idle connection of pool, Replenish() counted it in pool.Total already
+		private static async Task OpenIdleConnectionAsync(ConnectionPool pool)
+		{
+			ConnectionInfo info = null;
+
+			try
 			{
-				PqsqlWrapper.PQfinish(conn); // close connection and release memory
+				IntPtr conn = await SetupPGConnAsync(pool.ConnectionStringBuilder, pool.ConnectTimeout, CancellationToken.None).ConfigureAwait(false);
+
+				PGTransactionStatusType tranStatus;
+				if (GetStatus(conn, out tranStatus) == ConnStatusType.CONNECTION_OK && tranStatus == PGTransactionStatusType.PQTRANS_IDLE)
+				{
+					info = new ConnectionInfo { pgconn = conn, released = Environment.TickCount };
+				}
+				else if (conn != IntPtr.Zero)
+				{
+					PqsqlWrapper.PQfinish(conn);
+				}
+			}
+			catch (PqsqlException)
+			{
+				// timeout expired, PoolService will try again
 			}
+			finally
+			{
+				// the new connection, or the slot we reserved, goes to the waiters first
+				Return(pool, info);
+			}
+		}
 
-			closeConnections.Clear();
+		// Summary:
+		//     Gets the pool of connStringBuilder. Callers should cache the result as long as
+		//     the connection string does not change.
+		public static ConnectionPool GetPool(PqsqlConnectionStringBuilder connStringBuilder)
+		{
+#if CODECONTRACTS
+			Contract.Requires<ArgumentNullException>(connStringBuilder != null);
+#else
+			if (connStringBuilder == null)
+				throw new ArgumentNullException(nameof(connStringBuilder));
+#endif
+
+			// the pool's private PqsqlConnectionStringBuilder guarantees that we only get "compatible"
+			// connections from our internal connection pool, e.g., application_name will be the same
+			ConnectionPool pool = mPools.GetOrAdd(connStringBuilder.ConnectionString, s => new ConnectionPool(s));
+
+			// pre-warm new pools with MinPoolSize connections
+			Replenish(pool);
+
+			return pool;
 		}
 
 
+		// setup null-terminated key-value arrays for the connection
+		private static void GetConnectionParameters(PqsqlConnectionStringBuilder connStringBuilder, out string[] keywords, out string[] values)
+		{
+			List<string> keys = new List<string>(connStringBuilder.Count + 1);
+			List<string> vals = new List<string>(connStringBuilder.Count + 1);
+
+			// get libpq keys and values from PqsqlConnectionStringBuilder
+			foreach (string key in connStringBuilder.Keys)
+			{
+				if (PqsqlConnectionStringBuilder.IsProviderKeyword(key))
+					continue;
+
+				keys.Add(key);
+				vals.Add(Convert.ToString(connStringBuilder[key], CultureInfo.InvariantCulture));
+			}
+
+			keys.Add(null);
+			vals.Add(null);
+
+			keywords = keys.ToArray();
+			values = vals.ToArray();
+		}
+
 		internal static IntPtr SetupPGConn(PqsqlConnectionStringBuilder connStringBuilder, out ConnStatusType connStatus, out PGTransactionStatusType tranStatus)
 		{
 #if CODECONTRACTS
@@ -150,25 +333,96 @@ namespace Pqsql
 				throw new ArgumentNullException(nameof(connStringBuilder));
 #endif
 
-			// setup null-terminated key-value arrays for the connection
-			string[] keys = new string[connStringBuilder.Keys.Count + 1];
-			string[] vals = new string[connStringBuilder.Values.Count + 1];
-
-			// get keys and values from PqsqlConnectionStringBuilder
-			connStringBuilder.Keys.CopyTo(keys, 0);
-			connStringBuilder.Values.CopyTo(vals, 0);
+			string[] keys;
+			string[] vals;
+			GetConnectionParameters(connStringBuilder, out keys, out vals);
 
 			// now create connection
 			IntPtr conn = PqsqlWrapper.PQconnectdbParams(keys, vals, 0);
 
+			connStatus = SetupClientEncoding(conn, out tranStatus);
+			return conn;
+		}
+
+		// Summary:
+		//     Creates a new connection with PQconnectStartParams() and drives PQconnectPoll()
+		//     on socket readiness, so no thread is blocked while connecting. timeout is the
+		//     connect_timeout in seconds (0 waits forever), libpq ignores it for PQconnectPoll().
+		//     Use GetStatus() to retrieve the status of the returned connection.
+		internal static async Task<IntPtr> SetupPGConnAsync(PqsqlConnectionStringBuilder connStringBuilder, int timeout, CancellationToken cancellationToken)
+		{
+#if CODECONTRACTS
+			Contract.Requires<ArgumentNullException>(connStringBuilder != null);
+#else
+			if (connStringBuilder == null)
+				throw new ArgumentNullException(nameof(connStringBuilder));
+#endif
+
+			string[] keys;
+			string[] vals;
+			GetConnectionParameters(connStringBuilder, out keys, out vals);
+
+			IntPtr conn = PqsqlWrapper.PQconnectStartParams(keys, vals, 0);
+
+			if (conn == IntPtr.Zero || PqsqlWrapper.PQstatus(conn) == ConnStatusType.CONNECTION_BAD)
+				return conn;
+
+			using (CancellationTokenSource cts = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+			{
+				if (timeout > 0)
+				{
+					cts.CancelAfter(timeout * 1000);
+				}
+
+				try
+				{
+					// start as if PQconnectPoll() returned PGRES_POLLING_WRITING
+					PostgresPollingStatus poll = PostgresPollingStatus.PGRES_POLLING_WRITING;
+
+					while (poll != PostgresPollingStatus.PGRES_POLLING_OK && poll != PostgresPollingStatus.PGRES_POLLING_FAILED)
+					{
+						int events = poll == PostgresPollingStatus.PGRES_POLLING_READING ? PqsqlBinaryFormat.PQSW_READ : PqsqlBinaryFormat.PQSW_WRITE;
+
+						// the socket may change while libpq tries multiple hosts
+						await PqsqlSocketWaiter.WaitAsync(conn, events, cts.Token).ConfigureAwait(false);
+
+						poll = (PostgresPollingStatus) PqsqlWrapper.PQconnectPoll(conn);
+					}
+				}
+				catch (OperationCanceledException) when (!cancellationToken.IsCancellationRequested)
+				{
+					PqsqlWrapper.PQfinish(conn);
+					throw new PqsqlException("Could not create connection: timeout expired", (int) PqsqlState.CONNECTION_FAILURE);
+				}
+				catch
+				{
+					PqsqlWrapper.PQfinish(conn);
+					throw;
+				}
+			}
+
+			return conn;
+		}
+
+		// Summary:
+		//     Gets the connection and transaction status of a connection created by
+		//     SetupPGConnAsync(), after forcing client_encoding to utf8.
+		internal static ConnStatusType GetStatus(IntPtr conn, out PGTransactionStatusType tranStatus)
+		{
+			return SetupClientEncoding(conn, out tranStatus);
+		}
+
+		// always force client_encoding to utf8, returns the connection status of conn
+		private static ConnStatusType SetupClientEncoding(IntPtr conn, out PGTransactionStatusType tranStatus)
+		{
+			ConnStatusType connStatus;
+
 			if (conn == IntPtr.Zero)
 			{
-				connStatus = ConnStatusType.CONNECTION_BAD;
 				tranStatus = PGTransactionStatusType.PQTRANS_UNKNOWN;
-				return conn;
+				return ConnStatusType.CONNECTION_BAD;
 			}
 
-			// always force client_encoding to utf8
 			int client_encoding = PqsqlWrapper.PQclientEncoding(conn);
 
 			if (client_encoding == (int) PgEnc.PG_UTF8) // done
@@ -195,73 +449,300 @@ namespace Pqsql
 				}
 			}
 
-			return conn;
+			return connStatus;
 		}
 
 
-		public static IntPtr GetPGConn(PqsqlConnectionStringBuilder connStringBuilder, out ConnStatusType connStatus, out PGTransactionStatusType tranStatus)
+		// Summary:
+		//     Takes a connection from pool, or creates a new one. If MaxPoolSize connections
+		//     of pool are in use, we wait up to connect_timeout seconds for a connection
+		//     released by another PqsqlConnection. statements is set to the prepared
+		//     statements of the session of a pooled connection.
+		public static IntPtr GetPGConn(ConnectionPool pool, out PqsqlPreparedStatementCache statements, out ConnStatusType connStatus, out PGTransactionStatusType tranStatus)
 		{
 #if CODECONTRACTS
-			Contract.Requires<ArgumentNullException>(connStringBuilder != null);
+			Contract.Requires<ArgumentNullException>(pool != null);
 #else
-			if (connStringBuilder == null)
-				throw new ArgumentNullException(nameof(connStringBuilder));
+			if (pool == null)
+				throw new ArgumentNullException(nameof(pool));
 #endif
 
-			Queue<ConnectionInfo> queue;
-			IntPtr pgConn = IntPtr.Zero;
+			ConnectionInfo i;
 
-			lock (mPooledConnsLock)
+			if (!TakeOrReserve(pool, out i))
 			{
-				// connStringBuilder guarantees that we only get "compatible" connections from our internal
-				// connection pool, e.g., application_name will be the same
-				if (!mPooledConns.TryGetValue(connStringBuilder, out queue))
-				{
-					queue = new Queue<ConnectionInfo>();
-					mPooledConns[connStringBuilder] = queue;
-				}
+				i = WaitPGConn(pool);
 			}
 
-			lock (queue)
+			if (CheckOrRelease(i, IsRecent(pool, i), out connStatus, out tranStatus))
 			{
-				int count = queue.Count;
-				if (count > 0)
-				{
-					ConnectionInfo i = queue.Dequeue();
+				statements = i.statements;
+				return i.pgconn;
+			}
+
+			// we own a slot in pool.Total: we reserved it, or CheckOrRelease closed the connection of i
+			statements = null;
+			IntPtr pgConn = SetupPGConn(pool.ConnectionStringBuilder, out connStatus, out tranStatus);
+
+			if (pgConn == IntPtr.Zero)
+			{
+				Return(pool, null);
+			}
+
+			return pgConn;
+		}
+
+		// Summary:
+		//     Like GetPGConn(), but new connections are created with SetupPGConnAsync() and
+		//     we wait asynchronously for released connections.
+		//     Returns the connection and its prepared statements, use GetStatus() to
+		//     retrieve the status of the returned connection.
+		public static async Task<ConnectionInfo> GetPGConnAsync(ConnectionPool pool, int timeout, CancellationToken cancellationToken)
+		{
 #if CODECONTRACTS
-					Contract.Assume(i != null);
+			Contract.Requires<ArgumentNullException>(pool != null);
+#else
+			if (pool == null)
+				throw new ArgumentNullException(nameof(pool));
 #endif
-					pgConn = i.pgconn;
 
-					if (count > 1)
+			ConnectionInfo i;
+
+			if (!TakeOrReserve(pool, out i))
+			{
+				i = await WaitPGConnAsync(pool, timeout, cancellationToken).ConfigureAwait(false);
+			}
+
+			ConnStatusType connStatus;
+			PGTransactionStatusType tranStatus;
+
+			if (CheckOrRelease(i, IsRecent(pool, i), out connStatus, out tranStatus))
+				return i;
+
+			// we own a slot in pool.Total: we reserved it, or CheckOrRelease closed the connection of i
+			IntPtr pgConn;
+
+			try
+			{
+				pgConn = await SetupPGConnAsync(pool.ConnectionStringBuilder, timeout, cancellationToken).ConfigureAwait(false);
+			}
+			catch
+			{
+				Return(pool, null);
+				throw;
+			}
+
+			if (pgConn == IntPtr.Zero)
+			{
+				Return(pool, null);
+			}
+
+			return new ConnectionInfo { pgconn = pgConn };
+		}
+
+		// take the most recently released connection of pool into info, or reserve a slot in
+		// pool.Total for a new connection (info is null). false if MaxPoolSize connections are in use
+		private static bool TakeOrReserve(ConnectionPool pool, out ConnectionInfo info)
+		{
+			info = TakePGConn(pool);
+			return info != null || TryReserve(pool);
+		}
+
+		// take the most recently released connection of pool, null if there is none
+		private static ConnectionInfo TakePGConn(ConnectionPool pool)
+		{
+			ConnectionInfo i;
+
+			if (!pool.Idle.TryPop(out i))
+				return null;
+
+			Interlocked.Decrement(ref pool.Count);
+			return i;
+		}
+
+		// count a new connection in pool.Total, false if pool has MaxPoolSize connections already
+		private static bool TryReserve(ConnectionPool pool)
+		{
+			int total;
+
+			while ((total = Volatile.Read(ref pool.Total)) < pool.MaxPoolSize)
+			{
+				if (Interlocked.CompareExchange(ref pool.Total, total + 1, total) == total)
+					return true;
+			}
+
+			return false;
+		}
+
+		// true if info has been released within the validation interval of pool
+		private static bool IsRecent(ConnectionPool pool, ConnectionInfo info)
+		{
+			if (info == null)
+				return false;
+
+			int idle = unchecked(Environment.TickCount - info.released);
+			return idle >= 0 && idle < pool.ValidationInterval;
+		}
+
+		// Summary:
+		//     Appends a waiter for the next connection returned to pool. The task completes
+		//     with the connection, or with null if the slot of a closed connection in
+		//     pool.Total has been passed to the waiter.
+		private static TaskCompletionSource<ConnectionInfo> Enqueue(ConnectionPool pool)
+		{
+			TaskCompletionSource<ConnectionInfo> waiter = new TaskCompletionSource<ConnectionInfo>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+			lock (pool.Waiters)
+			{
+				pool.Waiters.Enqueue(waiter);
+				Interlocked.Increment(ref pool.WaiterCount);
+			}
+
+			// a connection returned before we were enqueued goes to the first waiter
+			ConnectionInfo i;
+			if (TakeOrReserve(pool, out i))
+			{
+				Return(pool, i);
+			}
+
+			return waiter;
+		}
+
+		// wait up to connect_timeout seconds for a connection returned to pool
+		private static ConnectionInfo WaitPGConn(ConnectionPool pool)
+		{
+			TaskCompletionSource<ConnectionInfo> waiter = Enqueue(pool);
+
+			int timeout = pool.ConnectTimeout > 0 ? (int) Math.Min(pool.ConnectTimeout * 1000L, int.MaxValue) : Timeout.Infinite;
+
+			// a connection handed to us before we give up is used, not lost
+			if (!waiter.Task.Wait(timeout) && waiter.TrySetCanceled())
+			{
+				throw PoolTimeout(pool);
+			}
+
+			return waiter.Task.Result;
+		}
+
+		// wait up to timeout seconds asynchronously for a connection returned to pool
+		private static async Task<ConnectionInfo> WaitPGConnAsync(ConnectionPool pool, int timeout, CancellationToken cancellationToken)
+		{
+			TaskCompletionSource<ConnectionInfo> waiter = Enqueue(pool);
+
+			using (CancellationTokenSource cts = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+			{
+				if (timeout > 0)
+				{
+					cts.CancelAfter(timeout * 1000);
+				}
+
+				// a connection handed to us before we give up is used, not lost
+				using (cts.Token.Register(() => waiter.TrySetCanceled()))
+				{
+					try
 					{
-						// head of queue will inherit old visited count
-						ConnectionInfo j = queue.Peek();
-#if CODECONTRACTS
-						Contract.Assume(j != null);
-#endif
-						j.visited = i.visited;
+						return await waiter.Task.ConfigureAwait(false);
+					}
+					catch (OperationCanceledException) when (!cancellationToken.IsCancellationRequested)
+					{
+						throw PoolTimeout(pool);
 					}
 				}
 			}
+		}
 
-			if (!CheckOrRelease(pgConn, out connStatus, out tranStatus))
+		private static PqsqlException PoolTimeout(ConnectionPool pool)
+		{
+			string msg = string.Format(CultureInfo.InvariantCulture, "Could not get connection: timeout expired, all {0} connections of the connection pool are in use", pool.MaxPoolSize);
+			return new PqsqlException(msg, (int) PqsqlState.CONNECTION_FAILURE);
+		}
+
+		// Summary:
+		//     Hands info to the longest waiting waiter of pool, otherwise info becomes an
+		//     idle connection. If info is null, the slot of a closed connection in
+		//     pool.Total is handed over or freed.
+		private static void Return(ConnectionPool pool, ConnectionInfo info)
+		{
+			for (;;)
 			{
-				pgConn = SetupPGConn(connStringBuilder, out connStatus, out tranStatus);
+				if (Volatile.Read(ref pool.WaiterCount) > 0 && Dispatch(pool, info))
+					return;
+
+				if (info == null)
+				{
+					Interlocked.Decrement(ref pool.Total);
+				}
+				else
+				{
+					Interlocked.Increment(ref pool.Count);
+					pool.Idle.Push(info);
+				}
+
+				// a waiter enqueued after we checked WaiterCount might have missed info
+				if (Volatile.Read(ref pool.WaiterCount) == 0 || !TakeOrReserve(pool, out info))
+					return;
 			}
+		}
 
-			return pgConn;
+		// hand info to the first waiter of pool which did not give up yet
+		private static bool Dispatch(ConnectionPool pool, ConnectionInfo info)
+		{
+			lock (pool.Waiters)
+			{
+				while (pool.Waiters.Count > 0)
+				{
+					TaskCompletionSource<ConnectionInfo> waiter = pool.Waiters.Dequeue();
+					Interlocked.Decrement(ref pool.WaiterCount);
+
+					if (waiter.TrySetResult(info))
+						return true;
+				}
+			}
+
+			return false;
 		}
 
-		private static bool CheckOrRelease(IntPtr pgConn, out ConnStatusType connStatus, out PGTransactionStatusType tranStatus)
+		// Summary:
+		//     Checks whether the connection of info can be reused, otherwise tries to reset it
+		//     and finally releases it. If recent is set, or the session reset sent by
+		//     ReleasePGConn has just been answered, we trust the connection as long as a
+		//     non-blocking poll of its socket does not report a hangup, otherwise the empty
+		//     query is sent.
+		private static bool CheckOrRelease(ConnectionInfo info, bool recent, out ConnStatusType connStatus, out PGTransactionStatusType tranStatus)
 		{
-			if (pgConn == IntPtr.Zero)
+			if (info == null)
 			{
 				connStatus = ConnStatusType.CONNECTION_BAD;
 				tranStatus = PGTransactionStatusType.PQTRANS_UNKNOWN;
 				return false;
 			}
 
+			IntPtr pgConn = info.pgconn;
+
+			if (info.resetPending)
+			{
+				info.resetPending = false;
+
+				// consume the results of the session reset, PQgetResult only blocks if the server did not answer yet
+				IntPtr res;
+				ExecStatusType st = ExecStatusType.PGRES_COMMAND_OK;
+				while ((res = PqsqlWrapper.PQgetResult(pgConn)) != IntPtr.Zero)
+				{
+					ExecStatusType st0 = PqsqlWrapper.PQresultStatus(res);
+
+					if (st0 != ExecStatusType.PGRES_COMMAND_OK && st0 != ExecStatusType.PGRES_TUPLES_OK)
+						st = st0;
+
+					// always free res
+					PqsqlWrapper.PQclear(res);
+				}
+
+				if (st != ExecStatusType.PGRES_COMMAND_OK) // session reset failed
+					goto broken;
+
+				recent = true; // the session reset was our round trip
+			}
+
 			// is connection reusable?
 			connStatus = PqsqlWrapper.PQstatus(pgConn);
 			if (connStatus != ConnStatusType.CONNECTION_OK)
@@ -281,7 +762,19 @@ namespace Pqsql
 			if (client_encoding == -1)
 				goto broken;
 
-			if (client_encoding == (int) PgEnc.PG_UTF8) // client_encoding == utf8
+			if (client_encoding == (int) PgEnc.PG_UTF8 && recent) // recently used or reset connection
+			{
+				// an idle connection only becomes readable if the server closed it, or sent a notice / notification
+				int ready = PqsqlBinaryFormat.pqsw_wait(pgConn, PqsqlBinaryFormat.PQSW_READ, 0);
+
+				if (ready < 0)
+					goto broken;
+
+				// PQconsumeInput fails on EOF and sets CONNECTION_BAD
+				if (ready > 0 && (PqsqlWrapper.PQconsumeInput(pgConn) == 0 || PqsqlWrapper.PQstatus(pgConn) != ConnStatusType.CONNECTION_OK))
+					goto broken;
+			}
+			else if (client_encoding == (int) PgEnc.PG_UTF8) // client_encoding == utf8
 			{
 				// send empty query to test whether we are really connected (tcp_keepalive might have closed socket)
 				unsafe
@@ -323,8 +816,9 @@ namespace Pqsql
 			return true; // successfully reused connection
 
 		broken:
-			// reconnect with current connection setting
+			// reconnect with current connection setting, prepared statements are gone with the old session
 			PqsqlWrapper.PQreset(pgConn);
+			info.statements?.Clear();
 
 			connStatus = PqsqlWrapper.PQstatus(pgConn);
 			if (connStatus == ConnStatusType.CONNECTION_OK)
@@ -343,51 +837,85 @@ namespace Pqsql
 			return false;
 		}
 
-		public static void ReleasePGConn(PqsqlConnectionStringBuilder connStringBuilder, IntPtr pgConnHandle)
+		// Summary:
+		//     Releases pgConnHandle to pool. The session reset of pool is sent without
+		//     waiting for its result, the result is consumed when the connection is taken
+		//     from the pool again. statements are the prepared statements of the session,
+		//     sessionChanged is set if the session state might have been changed.
+		public static void ReleasePGConn(ConnectionPool pool, IntPtr pgConnHandle, PqsqlPreparedStatementCache statements, bool sessionChanged)
 		{
 #if CODECONTRACTS
-			Contract.Requires<ArgumentNullException>(connStringBuilder != null);
+			Contract.Requires<ArgumentNullException>(pool != null);
 #else
-			if (connStringBuilder == null)
-				throw new ArgumentNullException(nameof(connStringBuilder));
+			if (pool == null)
+				throw new ArgumentNullException(nameof(pool));
 #endif
 
 			if (pgConnHandle == IntPtr.Zero)
 				return;
 
-			Queue<ConnectionInfo> queue;
+			bool resetPending;
 
-			lock (mPooledConnsLock)
+			if (ResetConnection(pgConnHandle, GetResetStatement(pool, statements, sessionChanged), out resetPending))
 			{
-				mPooledConns.TryGetValue(connStringBuilder, out queue);
+				// hand the connection directly to the next waiter, or keep it in the pool
+				Return(pool, new ConnectionInfo { pgconn = pgConnHandle, released = Environment.TickCount, statements = statements, resetPending = resetPending });
+				return;
 			}
 
-			bool closeConnection = true;
+			DiscardPGConn(pool, pgConnHandle);
+		}
 
-			if (queue == null || !DiscardConnection(pgConnHandle))
-			{
-				goto close; // just cleanup connection and restart timer
-			}
+		// Summary:
+		//     Closes pgConnHandle of pool instead of releasing it to the pool, e.g., if
+		//     the connection is broken.
+		public static void DiscardPGConn(ConnectionPool pool, IntPtr pgConnHandle)
+		{
+#if CODECONTRACTS
+			Contract.Requires<ArgumentNullException>(pool != null);
+#else
+			if (pool == null)
+				throw new ArgumentNullException(nameof(pool));
+#endif
 
-			lock (queue)
-			{
-				if (queue.Count < MaxQueue)
-				{
-					queue.Enqueue(new ConnectionInfo{ pgconn = pgConnHandle, visited = 0 });
-					closeConnection = false; // keep connection
-				}
-			}
+			if (pgConnHandle == IntPtr.Zero)
+				return;
+
+			PqsqlWrapper.PQfinish(pgConnHandle); // close connection and release memory
 
-		close:
-			if (closeConnection)
+			// the next waiter may open a new connection instead
+			Return(pool, null);
+
+			// open a replacement in the background if we fell below MinPoolSize
+			Replenish(pool);
+		}
+
+		// the session reset statement of pool, null if the session must not be reset
+		private static byte[] GetResetStatement(ConnectionPool pool, PqsqlPreparedStatementCache statements, bool sessionChanged)
+		{
+			switch (pool.SessionReset)
 			{
-				PqsqlWrapper.PQfinish(pgConnHandle); // close connection and release memory
+				case PqsqlSessionReset.ResetAll:
+					return ResetAllStatement;
+
+				case PqsqlSessionReset.None:
+					return null;
+
+				case PqsqlSessionReset.Changed:
+					if (!sessionChanged)
+						return null;
+					break;
 			}
+
+			statements?.Clear(); // DISCARD ALL deallocates all prepared statements
+			return DiscardAllStatement;
 		}
 
 
-		private static bool DiscardConnection(IntPtr conn)
+		private static bool ResetConnection(IntPtr conn, byte[] reset, out bool resetPending)
 		{
+			resetPending = false;
+
 			if (conn == IntPtr.Zero)
 				return false;
 
@@ -439,30 +967,22 @@ namespace Pqsql
 				{
 					return false; // connection broken
 				}
-
-				s = ExecStatusType.PGRES_FATAL_ERROR;
 			}
 
-			// discard connection
+			if (reset == null)
+				return true; // keep session
+
+			// send session reset, we do not wait for its result here
 			unsafe
 			{
-				fixed (byte* st = DiscardAllStatement)
+				fixed (byte* st = reset)
 				{
-					res = PqsqlWrapper.PQexec(conn, st);
-
-					if (res != IntPtr.Zero)
-					{
-						s = PqsqlWrapper.PQresultStatus(res);
-						PqsqlWrapper.PQclear(res);
-					}
+					if (PqsqlWrapper.PQsendQuery(conn, st) == 0)
+						return false; // connection broken
 				}
 			}
 
-			if (s != ExecStatusType.PGRES_COMMAND_OK)
-			{
-				return false; // connection broken
-			}
-
+			resetPending = true;
 			return true; // connection successfully resetted
 		}
 
@@ -473,7 +993,7 @@ namespace Pqsql
 			try
 			{
 				h = new AutoResetEvent(false);
-				if (mTimer.Dispose(h) && !h.WaitOne(IdleTimeout))
+				if (mTimer.Dispose(h) && !h.WaitOne(ServiceInterval))
 				{
 					throw new TimeoutException("Connection pool timer timeout");
 				}
@@ -483,31 +1003,23 @@ namespace Pqsql
 				h?.Dispose();
 			}
 
-			// discard all pooled connections
-			lock (mPooledConnsLock)
+			// close all pooled connections, the (empty) pools stay cached in PqsqlConnection objects
+			foreach (ConnectionPool pool in mPools.Values)
 			{
-				foreach (KeyValuePair<PqsqlConnectionStringBuilder, Queue<ConnectionInfo>> kv in mPooledConns)
-				{
-					Queue<ConnectionInfo> queue = kv.Value;
+				pool.Multiplexer?.Clear();
 
-					if (queue == null)
-						continue;
+				ConnectionInfo i;
 
-					lock (queue)
-					{
-						foreach (ConnectionInfo conninfo in queue)
-						{
-							DiscardConnection(conninfo.pgconn);
-						}
-						queue.Clear();
-					}
+				while (pool.Idle.TryPop(out i))
+				{
+					Interlocked.Decrement(ref pool.Count);
+					Interlocked.Decrement(ref pool.Total);
+					PqsqlWrapper.PQfinish(i.pgconn);
 				}
-
-				mPooledConns.Clear();
 			}
 
 			// restart pool service
-			mTimer = new Timer(PoolService, new List<IntPtr>(), IdleTimeout, IdleTimeout);
+			mTimer = new Timer(PoolService, new List<IntPtr>(), ServiceInterval, ServiceInterval);
 		}
 	}
 }
@@ -8,6 +8,19 @@ using System.Diagnostics.Contracts;
 
 namespace Pqsql
 {
+	// session reset of connections released to the connection pool
+	public enum PqsqlSessionReset
+	{
+		// DISCARD ALL
+		DiscardAll,
+		// reset the session, but keep prepared statements and cached plans
+		ResetAll,
+		// DISCARD ALL, but only if the session state might have changed
+		Changed,
+		// only roll back open transactions
+		None
+	}
+
 	// https://www.postgresql.org/docs/current/static/libpq-connect.html#LIBPQ-CONNSTRING
 	// The currently recognized parameter key words are:
 	//
@@ -114,6 +127,46 @@ namespace Pqsql
 	//service
 	//    Service name to use for additional parameters. It specifies a service name in pg_service.conf that holds additional connection parameters. This allows applications to specify only a service name so connection parameters can be centrally maintained. See Section 31.16.
 	//
+	// Additionally, the following Pqsql-specific key words are recognized. They are not passed to libpq:
+	//
+	//max_auto_prepare
+	//    Maximum number of statements per connection which will be prepared automatically once they have been executed auto_prepare_min_usages times. Least recently used statements are deallocated when the limit is reached. Zero or not specified disables automatic preparation.
+	//
+	//auto_prepare_min_usages
+	//    Number of executions of a statement after which it will be prepared automatically if max_auto_prepare is set. Defaults to 5.
+	//
+	//result_chunk_size
+	//    If set to a value greater than 1, rows of large results are fetched in chunks of at most this many rows with libpq's chunked rows mode (requires libpq 17 or later, otherwise rows are fetched one by one in single-row mode). Defaults to 0.
+	//
+	//pipeline_mode
+	//    If set to true, all statements of a command are sent at once in libpq pipeline mode (requires libpq 14 or later). The statements then run in one implicit transaction, and an error aborts all remaining statements. Defaults to false.
+	//
+	//validation_interval
+	//    Pooled connections which have been released less than this many milliseconds ago are handed out after a non-blocking check of their socket, without the empty query round trip to the server. A connection closed by the server in the meantime then fails on its first command and is reported as Broken, the next Open() or command execution reconnects it. Defaults to 0, i.e., every pooled connection is validated with a round trip.
+	//
+	//session_reset
+	//    How the session of a connection is reset when it is released to the connection pool. The reset statement is sent on Close() and its result is consumed when the connection is taken from the pool again, where it replaces the validation round trip. There are four modes:
+	//    discard_all (default)
+	//        DISCARD ALL
+	//    reset_all
+	//        like DISCARD ALL, but prepared statements and cached plans are kept. Prepared statements of Pqsql stay cached with the pooled connection, statements prepared with PREPARE must not be prepared again
+	//    changed
+	//        DISCARD ALL, but only if the connection executed commands which might have changed the session state, e.g., SET, LISTEN, or CREATE TEMP TABLE. Commands are classified by their command tag, so every SELECT counts as a change, as it might call functions like set_config() or pg_advisory_lock(); only connections which executed nothing but INSERT, UPDATE, DELETE, MERGE, COPY, FETCH, MOVE, SHOW, and transaction control skip the reset. Multiplexed commands are not tracked, see multiplexing
+	//    none
+	//        only roll back open transactions
+	//
+	//min_pool_size
+	//    Minimum number of connections of the connection pool. Missing connections are opened asynchronously in the background, starting with the first use of the connection string. Defaults to 0.
+	//
+	//max_pool_size
+	//    Maximum number of connections of the connection pool. If all connections are in use, Open() waits up to connect_timeout seconds (forever without connect_timeout) for a connection released by another PqsqlConnection and throws a PqsqlException once the timeout expired, waiting requests are served first come, first served. Defaults to 0, i.e., the number of connections is not limited.
+	//
+	//connection_idle_lifetime
+	//    Number of seconds after which idle connections exceeding min_pool_size are closed. The connection pool closes at most half of its idle connections every 30 seconds. Defaults to 60.
+	//
+	//multiplexing
+	//    Number of pooled connections shared by all PqsqlConnection objects of the connection string (requires libpq 14 or later). Open() then takes no connection from the pool: ExecuteScalar() and ExecuteNonQuery() of commands with a single statement and without CommandTimeout, except stored procedures and prepared commands, are sent in pipeline mode to the shared connection with the fewest pending commands. Each of these commands runs in its own implicit transaction, so they must not depend on the session state. Only statements starting with SELECT, VALUES, TABLE, WITH, INSERT, UPDATE, DELETE, MERGE, or SHOW are multiplexed, queries with INTO are not. Transactions, data readers, COPY, and all other commands, e.g., BEGIN, SET, LISTEN, or CREATE TEMP TABLE, take a connection from the pool on first use and keep it until Close(). Functions changing the session state, like set_config() or pg_advisory_lock(), must not be called in multiplexed commands. Defaults to 0, i.e., no multiplexing.
+	//
 	public sealed class PqsqlConnectionStringBuilder : DbConnectionStringBuilder
 	{
 		public const string host = "host";
@@ -132,12 +185,36 @@ namespace Pqsql
 		public const string keepalives_interval = "keepalives_interval";
 		public const string keepalives_count = "keepalives_count";
 
+		// Pqsql-specific keywords
+		public const string max_auto_prepare = "max_auto_prepare";
+		public const string auto_prepare_min_usages = "auto_prepare_min_usages";
+		public const string pipeline_mode = "pipeline_mode";
+		public const string result_chunk_size = "result_chunk_size";
+		public const string validation_interval = "validation_interval";
+		public const string session_reset = "session_reset";
+		public const string min_pool_size = "min_pool_size";
+		public const string max_pool_size = "max_pool_size";
+		public const string connection_idle_lifetime = "connection_idle_lifetime";
+		public const string multiplexing = "multiplexing";
+
+		// keywords handled by Pqsql, these must not be passed to libpq
+		static readonly string[] providerKeywords = { max_auto_prepare, auto_prepare_min_usages, pipeline_mode, result_chunk_size, validation_interval, session_reset, min_pool_size, max_pool_size, connection_idle_lifetime, multiplexing };
+
 		// .NET connection string aliases will be replaced with their libpq equivalents
 		static readonly string[] hostAlias = { "server", "data source", "datasource", "address", "addr", "network address" };
 		static readonly string[] dbnameAlias = { "database", "initial catalog" };
 		static readonly string[] connect_timeoutAlias = { "connect timeout", "timeout" };
 		static readonly string[] userAlias = { "user id", "uid", "username", "user name" };
 		static readonly string[] passwordAlias = { "pwd" };
+		static readonly string[] max_auto_prepareAlias = { "max auto prepare" };
+		static readonly string[] auto_prepare_min_usagesAlias = { "auto prepare min usages" };
+		static readonly string[] pipeline_modeAlias = { "pipeline mode" };
+		static readonly string[] result_chunk_sizeAlias = { "result chunk size" };
+		static readonly string[] validation_intervalAlias = { "validation interval" };
+		static readonly string[] session_resetAlias = { "session reset" };
+		static readonly string[] min_pool_sizeAlias = { "min pool size", "minpoolsize" };
+		static readonly string[] max_pool_sizeAlias = { "max pool size", "maxpoolsize" };
+		static readonly string[] connection_idle_lifetimeAlias = { "connection idle lifetime" };
 
 		public PqsqlConnectionStringBuilder()
 		{
@@ -237,6 +314,17 @@ namespace Pqsql
 				Array.ForEach(userAlias, a => CanonicalConnectionKeyword(a, user));
 				Array.ForEach(passwordAlias, a => CanonicalConnectionKeyword(a, password));
 
+				// Pqsql-specific settings
+				Array.ForEach(max_auto_prepareAlias, a => CanonicalConnectionKeyword(a, max_auto_prepare));
+				Array.ForEach(auto_prepare_min_usagesAlias, a => CanonicalConnectionKeyword(a, auto_prepare_min_usages));
+				Array.ForEach(pipeline_modeAlias, a => CanonicalConnectionKeyword(a, pipeline_mode));
+				Array.ForEach(result_chunk_sizeAlias, a => CanonicalConnectionKeyword(a, result_chunk_size));
+				Array.ForEach(validation_intervalAlias, a => CanonicalConnectionKeyword(a, validation_interval));
+				Array.ForEach(session_resetAlias, a => CanonicalConnectionKeyword(a, session_reset));
+				Array.ForEach(min_pool_sizeAlias, a => CanonicalConnectionKeyword(a, min_pool_size));
+				Array.ForEach(max_pool_sizeAlias, a => CanonicalConnectionKeyword(a, max_pool_size));
+				Array.ForEach(connection_idle_lifetimeAlias, a => CanonicalConnectionKeyword(a, connection_idle_lifetime));
+
 				// always set default connect_timeout of at least 2 seconds
 				Array.ForEach(connect_timeoutAlias, CanonicalConnectionTimeout);
 				if (!ContainsKey(connect_timeout))
@@ -246,6 +334,138 @@ namespace Pqsql
 			}
 		}
 
+		//
+		// Summary:
+		//     Gets the maximum number of automatically prepared statements per connection.
+		//     0 disables automatic preparation.
+		public int MaxAutoPrepare
+		{
+			get { return GetInt32(max_auto_prepare, 0); }
+		}
+
+		//
+		// Summary:
+		//     Gets the number of executions after which a statement will be prepared automatically.
+		public int AutoPrepareMinUsages
+		{
+			get { return GetInt32(auto_prepare_min_usages, 5); }
+		}
+
+		//
+		// Summary:
+		//     Gets whether all statements of a command are sent at once in libpq pipeline mode.
+		public bool PipelineMode
+		{
+			get { return GetBoolean(pipeline_mode, false); }
+		}
+
+		//
+		// Summary:
+		//     Gets the maximum number of rows per result chunk. Values less than 2
+		//     fetch rows one by one.
+		public int ResultChunkSize
+		{
+			get { return GetInt32(result_chunk_size, 0); }
+		}
+
+		//
+		// Summary:
+		//     Gets the number of milliseconds after the release of a pooled connection
+		//     in which it is reused without a validation round trip.
+		public int ValidationInterval
+		{
+			get { return GetInt32(validation_interval, 0); }
+		}
+
+		//
+		// Summary:
+		//     Gets how the session of a connection is reset when it is released to the
+		//     connection pool.
+		public PqsqlSessionReset SessionReset
+		{
+			get
+			{
+				object o;
+				if (!TryGetValue(session_reset, out o))
+					return PqsqlSessionReset.DiscardAll;
+
+				// discard_all, reset_all, changed, none
+				string s = Convert.ToString(o, CultureInfo.InvariantCulture).Trim().Replace("_", string.Empty);
+				return (PqsqlSessionReset) Enum.Parse(typeof(PqsqlSessionReset), s, true);
+			}
+		}
+
+		//
+		// Summary:
+		//     Gets the minimum number of connections of the connection pool.
+		public int MinPoolSize
+		{
+			get { return GetInt32(min_pool_size, 0); }
+		}
+
+		//
+		// Summary:
+		//     Gets the maximum number of connections of the connection pool, 0 does not
+		//     limit the number of connections.
+		public int MaxPoolSize
+		{
+			get { return GetInt32(max_pool_size, 0); }
+		}
+
+		//
+		// Summary:
+		//     Gets the number of seconds after which idle connections exceeding MinPoolSize
+		//     are closed.
+		public int ConnectionIdleLifetime
+		{
+			get { return GetInt32(connection_idle_lifetime, 60); }
+		}
+
+		//
+		// Summary:
+		//     Gets the number of pooled connections shared by multiplexed commands.
+		//     0 disables multiplexing.
+		public int Multiplexing
+		{
+			get { return GetInt32(multiplexing, 0); }
+		}
+
+		// returns the integer value of keyword, or defaultValue if keyword is not set
+		private int GetInt32(string keyword, int defaultValue)
+		{
+			object o;
+			if (TryGetValue(keyword, out o))
+			{
+				return Convert.ToInt32(o, CultureInfo.InvariantCulture);
+			}
+
+			return defaultValue;
+		}
+
+		// returns the boolean value (true / false / on / off / yes / no / 1 / 0) of keyword, or defaultValue if keyword is not set
+		private bool GetBoolean(string keyword, bool defaultValue)
+		{
+			object o;
+			if (!TryGetValue(keyword, out o))
+				return defaultValue;
+
+			string s = Convert.ToString(o, CultureInfo.InvariantCulture).Trim();
+
+			if (s.Equals("on", StringComparison.OrdinalIgnoreCase) || s.Equals("yes", StringComparison.OrdinalIgnoreCase) || s == "1")
+				return true;
+
+			if (s.Equals("off", StringComparison.OrdinalIgnoreCase) || s.Equals("no", StringComparison.OrdinalIgnoreCase) || s == "0")
+				return false;
+
+			return bool.Parse(s);
+		}
+
+		// true if keyword is handled by Pqsql and must not be passed to libpq
+		internal static bool IsProviderKeyword(string keyword)
+		{
+			return Array.Exists(providerKeywords, k => k.Equals(keyword, StringComparison.OrdinalIgnoreCase));
+		}
+
 		public string GetConnectionStringWithObfuscatedPassword()
 		{
 			if (ConnectionString == null)
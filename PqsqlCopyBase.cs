@@ -10,6 +10,14 @@ using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
 
 namespace Pqsql
 {
+	// data format of COPY
+	public enum PqsqlCopyFormat
+	{
+		Binary,
+		Text,
+		Csv
+	}
+
 	public abstract class PqsqlCopyBase : IDisposable
 	{
 		// connection for COPY
@@ -27,6 +35,12 @@ namespace Pqsql
 
 		public string Table { get; set; }
 
+		// data format of COPY, the Write*/Read* methods require PqsqlCopyFormat.Binary
+		public PqsqlCopyFormat Format { get; set; } = PqsqlCopyFormat.Binary;
+
+		// size of the blocks of raw COPY data in CopyToStream and CopyFromStream
+		protected const int StreamBlockSize = 64 * 1024;
+
 		protected abstract string CopyStmtDirection { get; }
 
 		internal abstract ExecStatusType QueryResultType  { get; }
@@ -162,7 +176,18 @@ namespace Pqsql
 				sb.AppendFormat("({0})", QueryInternal);
 			}
 
-			sb.AppendFormat(" {0} BINARY", CopyStmtDirection);
+			switch (Format)
+			{
+			case PqsqlCopyFormat.Text:
+				sb.AppendFormat(" {0}", CopyStmtDirection);
+				break;
+			case PqsqlCopyFormat.Csv:
+				sb.AppendFormat(" {0} CSV", CopyStmtDirection);
+				break;
+			default:
+				sb.AppendFormat(" {0} BINARY", CopyStmtDirection);
+				break;
+			}
 
 			byte[] q = PqsqlUTF8Statement.CreateUTF8Statement(sb);
 
@@ -177,7 +202,7 @@ namespace Pqsql
 			}
 
 			// check first column format, current implementation will have all columns set to binary 
-			if (PqsqlWrapper.PQfformat(res, 0) == 0)
+			if (Format == PqsqlCopyFormat.Binary && PqsqlWrapper.PQfformat(res, 0) == 0)
 			{
 				mConn.Consume(res);
 				throw new PqsqlException("PqsqlCopyFrom only supports BINARY format.");
@@ -1,4 +1,7 @@
 ﻿using System;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
 #if CODECONTRACTS
 using System.Diagnostics.Contracts;
 #endif
@@ -10,7 +13,7 @@ namespace Pqsql
 {
 	public sealed class PqsqlCopyFrom : PqsqlCopyBase
 	{
-		// fixed-size column buffer, flushes content to db connection once page size is reached
+		// column buffer, flushes content to db connection once BufferSize is reached
 		private IntPtr mColBuf;
 
 		// variable-size binary value buffer, used to store encoded column values
@@ -19,8 +22,19 @@ namespace Pqsql
 		// field position in the current row
 		private int mPos;
 
+		// block buffer for CopyFromStream
+		private byte[] mStreamBuf;
+
+		// true from Start until the end-of-data indication has been sent
+		private bool mCopyInProgress;
+
 		protected override string CopyStmtDirection { get; } = "FROM STDIN";
 
+		// size of the native COPY FROM buffer and of the blocks sent by CopyFromStream in bytes,
+		// 0 uses the default sizes of 8k and 64k.
+		// column values filling more than half of the buffer are sent directly without buffering.
+		public int BufferSize { get; set; }
+
         internal override ExecStatusType QueryResultType { get; } = ExecStatusType.PGRES_COPY_IN;
         
 		public PqsqlCopyFrom(PqsqlConnection conn)
@@ -34,14 +48,26 @@ namespace Pqsql
 		public override void Start()
 		{
 			base.Start();
+			mCopyInProgress = true;
 
 			if (mColBuf != IntPtr.Zero)
 			{
 				PqsqlBinaryFormat.pqcb_free(mColBuf);
 			}
 
-			IntPtr conn = mConn.PGConnection;
-			mColBuf = PqsqlBinaryFormat.pqcb_create(conn, mColumns);
+			if (BufferSize < 0)
+				throw new ArgumentOutOfRangeException(nameof(BufferSize));
+
+			// the binary encoding of the Write* methods is only used with PqsqlCopyFormat.Binary
+			if (Format == PqsqlCopyFormat.Binary)
+			{
+				IntPtr conn = mConn.PGConnection;
+				mColBuf = PqsqlBinaryFormat.pqcb_create(conn, mColumns, (UIntPtr) BufferSize);
+			}
+			else
+			{
+				mColBuf = IntPtr.Zero;
+			}
 		}
 
         public override void Close()
@@ -61,18 +87,112 @@ namespace Pqsql
 		
 		public void End()
 		{
-			IntPtr res;
-			string err = string.Empty;
+			if (!mCopyInProgress)
+				return; // not started, or already ended by CopyFromStream
+
+			int ret;
+
+			if (mColBuf != IntPtr.Zero)
+			{
+				ret = PqsqlBinaryFormat.pqcb_put_end(mColBuf); // flush column buffer
+			}
+			else
+			{
+				// text or csv COPY without data
+				unsafe
+				{
+					ret = PqsqlWrapper.PQputCopyEnd(mConn.PGConnection, null);
+				}
+			}
+
+			EndCopy(ret);
+		}
+
+		// the Write* methods encode their values for PqsqlCopyFormat.Binary into mColBuf
+		private void CheckColumnBuffer()
+		{
+			if (mColBuf == IntPtr.Zero)
+				throw new InvalidOperationException("The Write methods require PqsqlCopyFormat.Binary and cannot be used together with CopyFromStream");
+		}
+
+		//
+		// Summary:
+		//     Sends the content of stream as COPY data in large blocks, without parsing
+		//     or encoding rows, and ends the COPY. The stream must contain COPY data in
+		//     the format given by Format, e.g., the output of PqsqlCopyTo.CopyToStream.
+		//     The Write* methods must not be used together with CopyFromStream.
+		//
+		// Returns:
+		//     The number of bytes sent.
+		public long CopyFromStream(Stream stream)
+		{
+			if (stream == null)
+				throw new ArgumentNullException(nameof(stream));
 
 #if CODECONTRACTS
 			Contract.Assume(mConn != null);
 #endif
 			IntPtr conn = mConn.PGConnection;
 
-			if (mColBuf == IntPtr.Zero)
-				return;
+			// drop the binary COPY header of the column buffer, stream provides the complete COPY data
+			if (mColBuf != IntPtr.Zero)
+			{
+				PqsqlBinaryFormat.pqcb_free(mColBuf);
+				mColBuf = IntPtr.Zero;
+			}
+
+			int blockSize = BufferSize > 0 ? BufferSize : StreamBlockSize;
+			if (mStreamBuf == null || mStreamBuf.Length != blockSize)
+			{
+				mStreamBuf = new byte[blockSize];
+			}
 
-			int ret = PqsqlBinaryFormat.pqcb_put_end(mColBuf); // flush column buffer
+			long total = 0;
+			int n;
+
+			while ((n = stream.Read(mStreamBuf, 0, mStreamBuf.Length)) > 0)
+			{
+				int ret;
+
+				unsafe
+				{
+					fixed (byte* b = mStreamBuf)
+					{
+						ret = PqsqlWrapper.PQputCopyData(conn, (IntPtr) b, n);
+					}
+				}
+
+				if (ret != 1)
+				{
+					throw new PqsqlException("Could not send COPY data: " + Error());
+				}
+
+				total += n;
+			}
+
+			int end;
+			unsafe
+			{
+				end = PqsqlWrapper.PQputCopyEnd(conn, null);
+			}
+
+			EndCopy(end);
+
+			return total;
+		}
+
+		// processes the result of COPY FROM after end-of-data indication with result ret has been sent
+		private void EndCopy(int ret)
+		{
+			IntPtr res;
+			string err = string.Empty;
+
+			mCopyInProgress = false;
+
+#if CODECONTRACTS
+			Contract.Assume(mConn != null);
+#endif
+			IntPtr conn = mConn.PGConnection;
 
 			if (ret != 1)
 			{
@@ -160,6 +280,8 @@ namespace Pqsql
 			Contract.Ensures(mPos < mColumns);
 #endif
 
+			CheckColumnBuffer();
+
 			int ret = PqsqlBinaryFormat.pqcb_put_col(mColBuf, value, type_length);
 
 			if (ret < 1)
@@ -368,7 +490,7 @@ namespace Pqsql
 			long begin = LengthCheckReset();
 
 			// TODO try to infer destination datatype
-			PqsqlBinaryFormat.pqbf_set_numeric(mExpBuf, decimal.ToDouble(value));
+			PqsqlParameterBuffer.SetNumeric(mExpBuf, value);
 			long end = PqsqlBinaryFormat.pqbf_get_buflen(mExpBuf);
 
 			long len = end - begin;
@@ -400,6 +522,21 @@ namespace Pqsql
 			}
 		}
 
+		public int WriteBytes(byte[] value)
+		{
+			if (value == null)
+				return WriteNull();
+
+			// send bytes straight from the managed array, without staging them in mExpBuf
+			unsafe
+			{
+				fixed (byte* b = value)
+				{
+					return PutColumn((sbyte*) b, (uint) value.Length);
+				}
+			}
+		}
+
 		public int WriteTimestamp(DateTime value)
 		{
 			long begin = LengthCheckReset();
@@ -510,6 +647,242 @@ namespace Pqsql
 			}
 		}
 
+		// converts column into a blittable array matching the binary format of column type oid,
+		// variable-length values are concatenated and their lengths are stored in lens
+		private static Array GetBatchColumn(Array column, PqsqlColInfo ci, out int[] lens)
+		{
+			lens = null;
+
+			switch (ci.Oid)
+			{
+			case PqsqlDbType.Boolean:
+				bool[] bools = column as bool[];
+				if (bools == null)
+					break;
+
+				byte[] bs = new byte[bools.Length];
+				for (int i = 0; i < bools.Length; i++)
+				{
+					bs[i] = (byte) (bools[i] ? 1 : 0);
+				}
+				return bs;
+
+			case PqsqlDbType.Int2:
+				if (column is short[])
+					return column;
+				break;
+
+			case PqsqlDbType.Int4:
+			case PqsqlDbType.Oid:
+				if (column is int[])
+					return column;
+				break;
+
+			case PqsqlDbType.Int8:
+				if (column is long[])
+					return column;
+				break;
+
+			case PqsqlDbType.Float4:
+				if (column is float[])
+					return column;
+				break;
+
+			case PqsqlDbType.Float8:
+				if (column is double[])
+					return column;
+				break;
+
+			case PqsqlDbType.Timestamp:
+			case PqsqlDbType.TimestampTZ:
+				DateTime[] dts = column as DateTime[];
+				if (dts == null)
+					break;
+
+				long[] ts = new long[dts.Length];
+				for (int i = 0; i < dts.Length; i++)
+				{
+					ts[i] = PqsqlBinaryFormat.GetTimestampFromDateTime(dts[i]);
+				}
+				return ts;
+
+			case PqsqlDbType.Text:
+			case PqsqlDbType.Varchar:
+			case PqsqlDbType.BPChar:
+			case PqsqlDbType.Name:
+				string[] strs = column as string[];
+				if (strs == null)
+					break;
+
+				int total = 0;
+				lens = new int[strs.Length];
+				for (int i = 0; i < strs.Length; i++)
+				{
+					lens[i] = strs[i] == null ? -1 : Encoding.UTF8.GetByteCount(strs[i]);
+					total += Math.Max(lens[i], 0);
+				}
+
+				byte[] utf8 = new byte[total];
+				int pos = 0;
+				foreach (string s in strs)
+				{
+					if (s != null)
+						pos += Encoding.UTF8.GetBytes(s, 0, s.Length, utf8, pos);
+				}
+				return utf8;
+
+			case PqsqlDbType.Bytea:
+				byte[][] blobs = column as byte[][];
+				if (blobs == null)
+					break;
+
+				int size = 0;
+				lens = new int[blobs.Length];
+				for (int i = 0; i < blobs.Length; i++)
+				{
+					lens[i] = blobs[i]?.Length ?? -1;
+					size += Math.Max(lens[i], 0);
+				}
+
+				byte[] bytes = new byte[size];
+				size = 0;
+				foreach (byte[] b in blobs)
+				{
+					if (b != null)
+					{
+						Buffer.BlockCopy(b, 0, bytes, size, b.Length);
+						size += b.Length;
+					}
+				}
+				return bytes;
+			}
+
+			throw new PqsqlException("Column " + ci.ColumnName + ": cannot write " + column.GetType() + " to column of type " + ci.Oid);
+		}
+
+		//
+		// Summary:
+		//     Writes complete rows from column-major arrays with a single native call.
+		//     columns[i] holds the values of the i-th column of the COPY destination:
+		//     bool[] for boolean, short[] for int2, int[] for int4 and oid, long[] for int8,
+		//     float[] for float4, double[] for float8, DateTime[] for timestamp and timestamptz,
+		//     string[] for text, varchar, bpchar, and name, and byte[][] for bytea columns.
+		//     null elements of string[] and byte[][] are written as NULL.
+		//
+		// Parameters:
+		//   columns:
+		//     The column arrays, all of the same length.
+		//
+		//   nullmaps:
+		//     If not null, nullmaps[i] is null or a bitmap where bit j (least significant bit
+		//     first) is set iff row j of column i is NULL.
+		//
+		// Returns:
+		//     The number of rows written.
+		public int WriteBatch(Array[] columns, byte[][] nullmaps = null)
+		{
+			if (mRowInfo == null)
+				throw new InvalidOperationException("PqsqlCopyFrom.Start must be called before we can write data");
+
+			CheckColumnBuffer();
+
+			if (columns == null)
+				throw new ArgumentNullException(nameof(columns));
+
+			if (columns.Length != mColumns)
+				throw new ArgumentException("Number of column arrays must match number of columns " + mColumns, nameof(columns));
+
+			if (nullmaps != null && nullmaps.Length != mColumns)
+				throw new ArgumentException("Number of null bitmaps must match number of columns " + mColumns, nameof(nullmaps));
+
+			if (mPos != 0)
+				throw new InvalidOperationException("PqsqlCopyFrom.WriteBatch must start with a new row");
+
+			if (mColumns == 0)
+				return 0;
+
+			int nrows = columns[0]?.Length ?? 0;
+			Array[] values = new Array[mColumns];
+			int[][] lens = new int[mColumns][];
+
+			for (int i = 0; i < mColumns; i++)
+			{
+				if (columns[i] == null)
+					throw new ArgumentNullException(nameof(columns), "Column array " + i + " is null");
+
+				if (columns[i].Length != nrows)
+					throw new ArgumentException("Column arrays must have the same length", nameof(columns));
+
+				if (nullmaps?[i] != null && nullmaps[i].Length < (nrows + 7) / 8)
+					throw new ArgumentException("Null bitmap " + i + " too small", nameof(nullmaps));
+
+				PqsqlColInfo ci = mRowInfo[i];
+				if (ci == null)
+					throw new PqsqlException("PqsqlCopyFrom.Start could not setup column information for column " + i);
+
+				values[i] = GetBatchColumn(columns[i], ci, out lens[i]);
+			}
+
+			if (nrows == 0)
+				return 0;
+
+			// pin all column arrays during the native call
+			GCHandle[] handles = new GCHandle[3 * mColumns];
+			int ret;
+
+			try
+			{
+				PqsqlBinaryFormat.pqcopy_column[] cols = new PqsqlBinaryFormat.pqcopy_column[mColumns];
+
+				for (int i = 0; i < mColumns; i++)
+				{
+					handles[3 * i] = GCHandle.Alloc(values[i], GCHandleType.Pinned);
+					cols[i].oid = (uint) mRowInfo[i].Oid;
+
+					unsafe
+					{
+						cols[i].values = (void*) handles[3 * i].AddrOfPinnedObject();
+
+						if (lens[i] != null)
+						{
+							handles[3 * i + 1] = GCHandle.Alloc(lens[i], GCHandleType.Pinned);
+							cols[i].lens = (int*) handles[3 * i + 1].AddrOfPinnedObject();
+						}
+
+						if (nullmaps?[i] != null)
+						{
+							handles[3 * i + 2] = GCHandle.Alloc(nullmaps[i], GCHandleType.Pinned);
+							cols[i].nullmap = (byte*) handles[3 * i + 2].AddrOfPinnedObject();
+						}
+					}
+				}
+
+				unsafe
+				{
+					fixed (PqsqlBinaryFormat.pqcopy_column* c = cols)
+					{
+						ret = PqsqlBinaryFormat.pqcb_put_rows(mColBuf, c, mColumns, nrows);
+					}
+				}
+			}
+			finally
+			{
+				foreach (GCHandle h in handles)
+				{
+					if (h.IsAllocated)
+						h.Free();
+				}
+			}
+
+			if (ret < 1)
+			{
+				string err = mColBuf == IntPtr.Zero ? string.Empty : Error();
+				throw new PqsqlException(err);
+			}
+
+			return nrows;
+		}
+
 		public int WriteArray(Array value)
 		{
 			throw new NotImplementedException("WriteArray not implemented");
@@ -0,0 +1,207 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
+
+namespace Pqsql
+{
+	/// <summary>
+	/// receives the COPY data chunks of a PGconn with PQgetCopyData in async mode into a bounded
+	/// queue. While no complete chunk is available, we wait for socket readiness with
+	/// PqsqlSocketWaiter, so no thread is blocked.
+	/// </summary>
+	internal sealed class PqsqlCopyPrefetch : IDisposable
+	{
+		/// <summary>
+		/// a COPY data chunk, Data is allocated by libpq and must be released with PQfreemem
+		/// </summary>
+		internal struct Chunk
+		{
+			public IntPtr Data;
+			public int Length; // result of PQgetCopyData
+		}
+
+		private readonly IntPtr mPGConn;
+
+		private readonly ConcurrentQueue<Chunk> mChunks = new ConcurrentQueue<Chunk>();
+		private readonly SemaphoreSlim mChunksAvailable = new SemaphoreSlim(0);
+		private readonly SemaphoreSlim mChunkSlots;
+		private readonly CancellationTokenSource mCancel = new CancellationTokenSource();
+		private readonly Task mTask;
+
+		// the exception which stopped the prefetching, rethrown to the consumer
+		private Exception mError;
+
+		// the end of COPY data (-1) or error (-2) chunk once it has been taken, all further takes return it again
+		private Chunk? mLast;
+
+		public PqsqlCopyPrefetch(IntPtr conn, int capacity)
+		{
+			mPGConn = conn;
+			mChunkSlots = new SemaphoreSlim(capacity);
+			mTask = Run(mCancel.Token);
+		}
+
+		// receive chunks until the end of COPY data or an error
+		private async Task Run(CancellationToken ct)
+		{
+			IntPtr bufferPtr = Marshal.AllocHGlobal(IntPtr.Size);
+			Marshal.WriteIntPtr(bufferPtr, IntPtr.Zero);
+
+			try
+			{
+				int n;
+
+				do
+				{
+					n = PqsqlWrapper.PQgetCopyData(mPGConn, bufferPtr, 1);
+
+					if (n == 0)
+					{
+						// no complete row available, wait until socket is readable
+						await PqsqlSocketWaiter.WaitAsync(mPGConn, PqsqlBinaryFormat.PQSW_READ, ct).ConfigureAwait(false);
+
+						if (PqsqlWrapper.PQconsumeInput(mPGConn) == 0)
+						{
+							n = -2;
+						}
+						else
+						{
+							continue;
+						}
+					}
+
+					await mChunkSlots.WaitAsync(ct).ConfigureAwait(false);
+
+					mChunks.Enqueue(new Chunk { Data = Marshal.ReadIntPtr(bufferPtr), Length = n });
+					Marshal.WriteIntPtr(bufferPtr, IntPtr.Zero);
+
+					mChunksAvailable.Release();
+				} while (n >= 0);
+			}
+			catch (OperationCanceledException) when (ct.IsCancellationRequested)
+			{
+				// Dispose() cancelled us
+			}
+			catch (Exception e)
+			{
+				// let the consumer fail with e
+				mError = e;
+				mChunks.Enqueue(new Chunk { Data = IntPtr.Zero, Length = -2 });
+				mChunksAvailable.Release();
+			}
+			finally
+			{
+				IntPtr pending = Marshal.ReadIntPtr(bufferPtr);
+				if (pending != IntPtr.Zero)
+				{
+					PqsqlWrapper.PQfreemem(pending);
+				}
+
+				Marshal.FreeHGlobal(bufferPtr);
+			}
+		}
+
+		// Summary:
+		//     Takes the next chunk if one is available without waiting.
+		public bool TryTake(out Chunk chunk)
+		{
+			if (mLast.HasValue)
+			{
+				chunk = Last();
+				return true;
+			}
+
+			if (!mChunksAvailable.Wait(0))
+			{
+				chunk = default(Chunk);
+				return false;
+			}
+
+			chunk = Dequeue();
+			return true;
+		}
+
+		// Summary:
+		//     Waits for the next chunk.
+		public Chunk Take()
+		{
+			if (mLast.HasValue)
+				return Last();
+
+			mChunksAvailable.Wait();
+			return Dequeue();
+		}
+
+		// Summary:
+		//     Waits asynchronously for the next chunk.
+		public async Task<Chunk> TakeAsync(CancellationToken cancellationToken)
+		{
+			if (mLast.HasValue)
+				return Last();
+
+			await mChunksAvailable.WaitAsync(cancellationToken).ConfigureAwait(false);
+			return Dequeue();
+		}
+
+		// dequeue the next chunk after mChunksAvailable has been acquired
+		private Chunk Dequeue()
+		{
+			Chunk chunk;
+			mChunks.TryDequeue(out chunk);
+			mChunkSlots.Release();
+
+			if (chunk.Length < 0)
+			{
+				mLast = chunk;
+				return Last();
+			}
+
+			return chunk;
+		}
+
+		// the last chunk, or the exception which stopped the prefetching
+		private Chunk Last()
+		{
+			if (mError != null)
+			{
+				ExceptionDispatchInfo.Capture(mError).Throw();
+			}
+
+			return mLast.Value;
+		}
+
+		// Summary:
+		//     Stops receiving and releases all queued chunks.
+		public void Dispose()
+		{
+			mCancel.Cancel();
+
+			try
+			{
+				mTask.Wait();
+			}
+			catch (AggregateException)
+			{
+			}
+
+			Chunk chunk;
+			while (mChunks.TryDequeue(out chunk))
+			{
+				if (chunk.Data != IntPtr.Zero)
+				{
+					PqsqlWrapper.PQfreemem(chunk.Data);
+				}
+			}
+
+			mChunksAvailable.Dispose();
+			mChunkSlots.Dispose();
+			mCancel.Dispose();
+		}
+	}
+}
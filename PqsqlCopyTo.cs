@@ -1,6 +1,9 @@
 ﻿using System;
+using System.IO;
 using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
 using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
 using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
 
@@ -18,6 +21,15 @@ namespace Pqsql
 		private bool mHeaderReceived;
 		private IntPtr mRowStart;
 
+		// native reader for ReadBatch
+		private IntPtr mReader;
+
+		// byte buffers for variable-length columns in ReadBatch
+		private byte[][] mBatchBuffers;
+
+		// true once FinishCopy consumed the final result of the COPY
+		private bool mCopyFinished;
+
 		public PqsqlCopyTo(PqsqlConnection conn)
 			: base(conn)
 		{
@@ -51,6 +63,15 @@ namespace Pqsql
 
         public override void Close()
         {
+			// the prefetch task must not use the connection anymore
+			StopPrefetch();
+
+			if (mReader != IntPtr.Zero)
+			{
+				PqsqlBinaryFormat.pqcr_free(mReader);
+				mReader = IntPtr.Zero;
+			}
+
 			if (mBufferPtr == IntPtr.Zero)
 			{
 				return;
@@ -68,7 +89,49 @@ namespace Pqsql
 
 		public bool FetchRow()
 		{
-			var res = FetchRowCore();
+			if (mReader != IntPtr.Zero)
+			{
+				throw new InvalidOperationException($"{nameof(FetchRow)} cannot be called after {nameof(ReadBatch)}.");
+			}
+
+			if (mCopyFinished)
+			{
+				return false;
+			}
+
+			return ProcessRow(FetchRowCore());
+		}
+
+		// state of the COPY data chunk parsed by ParseRow
+		private enum RowState
+		{
+			Tuple,
+			Trailer,
+			End
+		}
+
+		// parses the header and the field count of COPY data chunk and reads the final chunk after the trailer,
+		// res is the result of PQgetCopyData
+		private bool ProcessRow(int res)
+		{
+			switch (ParseRow(res))
+			{
+				case RowState.Tuple:
+					return true;
+
+				case RowState.Trailer:
+					// we received the end trailer, read again (we expect -1) and return false
+					FinishTrailer(FetchRowCore());
+					return false;
+
+				default:
+					return false;
+			}
+		}
+
+		// parses the header and the field count of COPY data chunk, res is the result of PQgetCopyData
+		private RowState ParseRow(int res)
+		{
 			mReadPos = Buffer;
 
 			if (!mHeaderReceived)
@@ -117,45 +180,12 @@ namespace Pqsql
 				if (fieldCount == mColumns)
 				{
 					// got a tuple, continue
-					return true;
+					return RowState.Tuple;
 				}
 
 				if (fieldCount == -1)
 				{
-					// we received the end trailer, read again (we expect -1) and return false
-					var lastReadResult = FetchRowCore();
-					if (lastReadResult != -1)
-					{
-						throw new PqsqlException($"The read after the trailer didn't return -1, but '{lastReadResult}'.");
-					}
-
-					// get the final result from the conn, so we can return to normal operation
-					if (mPGConn == IntPtr.Zero)
-					{
-						throw new InvalidOperationException("Connection is closed.");
-					}
-
-					IntPtr result = PqsqlWrapper.PQgetResult(mPGConn);
-					if (result != IntPtr.Zero)
-					{
-						var s = PqsqlWrapper.PQresultStatus(result);
-						PqsqlWrapper.PQclear(result);
-
-						if (s == ExecStatusType.PGRES_COMMAND_OK)
-						{
-							// consume all remaining results until we reach the NULL result
-							while ((result = PqsqlWrapper.PQgetResult(mPGConn)) != IntPtr.Zero)
-							{
-								PqsqlWrapper.PQclear(result);
-							}
-
-							return false;
-						}
-
-						throw new PqsqlException($"COPY failed with status '{s}'.");
-					}
-					
-					throw new PqsqlException($"COPY failed with zero status code.");
+					return RowState.Trailer;
 				}
 
 				// we got an invalid fieldCount
@@ -170,7 +200,7 @@ namespace Pqsql
 			if (res == -1)
 			{
 				// EOF
-				return false;
+				return RowState.End;
 			}
 
 			// res < -1
@@ -178,6 +208,49 @@ namespace Pqsql
 			throw new PqsqlException(err);
 		}
 
+		// checks the result of the read after the trailer and finishes the COPY operation
+		private void FinishTrailer(int lastReadResult)
+		{
+			if (lastReadResult != -1)
+			{
+				throw new PqsqlException($"The read after the trailer didn't return -1, but '{lastReadResult}'.");
+			}
+
+			FinishCopy();
+		}
+
+		// get the final result from the conn, so we can return to normal operation
+		private void FinishCopy()
+		{
+			if (mPGConn == IntPtr.Zero)
+			{
+				throw new InvalidOperationException("Connection is closed.");
+			}
+
+			IntPtr result = PqsqlWrapper.PQgetResult(mPGConn);
+			if (result != IntPtr.Zero)
+			{
+				var s = PqsqlWrapper.PQresultStatus(result);
+				PqsqlWrapper.PQclear(result);
+
+				if (s == ExecStatusType.PGRES_COMMAND_OK)
+				{
+					// consume all remaining results until we reach the NULL result
+					while ((result = PqsqlWrapper.PQgetResult(mPGConn)) != IntPtr.Zero)
+					{
+						PqsqlWrapper.PQclear(result);
+					}
+
+					mCopyFinished = true;
+					return;
+				}
+
+				throw new PqsqlException($"COPY failed with status '{s}'.");
+			}
+
+			throw new PqsqlException($"COPY failed with zero status code.");
+		}
+
 		private int FetchRowCore()
 		{
 			if (mPGConn == IntPtr.Zero)
@@ -185,6 +258,12 @@ namespace Pqsql
 				throw new InvalidOperationException("Connection is closed.");
 			}
 
+			if (mPrefetch != null)
+			{
+				// FetchRowAsync started prefetching
+				return TakeChunk(mPrefetch.Take());
+			}
+
 			var buffer = Buffer;
 			if (buffer != IntPtr.Zero)
 			{
@@ -194,6 +273,197 @@ namespace Pqsql
 			return PqsqlWrapper.PQgetCopyData(mPGConn, mBufferPtr, 0);
 		}
 
+		#region raw interface
+
+		// block buffer for CopyToStream
+		private byte[] mStreamBuf;
+
+		//
+		// Summary:
+		//     Writes all COPY data to stream in large blocks, without parsing rows.
+		//     The data is written in the format given by Format, e.g., for
+		//     PqsqlCopyFrom.CopyFromStream. Must be called right after Start.
+		//
+		// Returns:
+		//     The number of bytes written.
+		public long CopyToStream(Stream stream)
+		{
+			if (stream == null)
+			{
+				throw new ArgumentNullException(nameof(stream));
+			}
+
+			if (mHeaderReceived || mReader != IntPtr.Zero || mPrefetch != null)
+			{
+				throw new InvalidOperationException($"{nameof(CopyToStream)} cannot be called after reading rows.");
+			}
+
+			if (mStreamBuf == null)
+			{
+				mStreamBuf = new byte[StreamBlockSize];
+			}
+
+			long total = 0;
+			int pos = 0;
+			int res;
+
+			// each COPY data chunk holds one row, collect them into blocks
+			while ((res = FetchRowCore()) > 0)
+			{
+				IntPtr chunk = Buffer;
+				int off = 0;
+
+				while (off < res)
+				{
+					int n = Math.Min(res - off, mStreamBuf.Length - pos);
+					Marshal.Copy(chunk + off, mStreamBuf, pos, n);
+					pos += n;
+					off += n;
+
+					if (pos == mStreamBuf.Length)
+					{
+						stream.Write(mStreamBuf, 0, pos);
+						pos = 0;
+					}
+				}
+
+				total += res;
+			}
+
+			if (res != -1)
+			{
+				throw new PqsqlException(Error());
+			}
+
+			if (pos > 0)
+			{
+				stream.Write(mStreamBuf, 0, pos);
+			}
+
+			FinishCopy();
+
+			return total;
+		}
+
+		#endregion
+
+		#region asynchronous interface
+
+		// COPY data chunks received in the background once FetchRowAsync has been called
+		private PqsqlCopyPrefetch mPrefetch;
+
+		//
+		// Summary:
+		//     Gets or sets the maximal number of COPY data chunks (rows) that are received
+		//     in the background once FetchRowAsync has been called.
+		public int PrefetchCount { get; set; } = 1024;
+
+		//
+		// Summary:
+		//     Asynchronously advances to the next row. The first call starts receiving
+		//     COPY data in the background into a queue of at most PrefetchCount rows,
+		//     waiting for socket readiness without blocking a thread. FetchRow then also
+		//     consumes rows from this queue.
+		//
+		// Returns:
+		//     true if there is another row, false at the end of the COPY data.
+		public Task<bool> FetchRowAsync(CancellationToken cancellationToken = default(CancellationToken))
+		{
+			if (mPGConn == IntPtr.Zero)
+			{
+				throw new InvalidOperationException("Connection is closed.");
+			}
+
+			if (mCopyFinished)
+			{
+				return Task.FromResult(false);
+			}
+
+			if (mPrefetch == null)
+			{
+				StartPrefetch();
+			}
+
+			// fast path: row already prefetched
+			PqsqlCopyPrefetch.Chunk chunk;
+			if (mPrefetch.TryTake(out chunk))
+			{
+				return ProcessRowAsync(TakeChunk(chunk), cancellationToken);
+			}
+
+			// no await here, we are in an unsafe context
+			return mPrefetch.TakeAsync(cancellationToken).ContinueWith(
+				t => ProcessRowAsync(TakeChunk(t.GetAwaiter().GetResult()), cancellationToken), // propagates cancellation and prefetch errors
+				CancellationToken.None, TaskContinuationOptions.None, TaskScheduler.Default).Unwrap();
+		}
+
+		// like ProcessRow, but takes the final chunk after the trailer from the prefetch queue without blocking
+		private Task<bool> ProcessRowAsync(int res, CancellationToken cancellationToken)
+		{
+			RowState state = ParseRow(res);
+			if (state != RowState.Trailer)
+			{
+				return Task.FromResult(state == RowState.Tuple);
+			}
+
+			PqsqlCopyPrefetch.Chunk chunk;
+			if (mPrefetch.TryTake(out chunk))
+			{
+				FinishTrailer(TakeChunk(chunk));
+				return Task.FromResult(false);
+			}
+
+			return mPrefetch.TakeAsync(cancellationToken).ContinueWith(
+				t =>
+				{
+					FinishTrailer(TakeChunk(t.GetAwaiter().GetResult()));
+					return false;
+				},
+				CancellationToken.None, TaskContinuationOptions.None, TaskScheduler.Default);
+		}
+
+		private void StartPrefetch()
+		{
+			if (mReader != IntPtr.Zero)
+			{
+				throw new InvalidOperationException($"{nameof(FetchRowAsync)} cannot be called after {nameof(ReadBatch)}.");
+			}
+
+			if (PrefetchCount <= 0)
+			{
+				throw new InvalidOperationException($"{nameof(PrefetchCount)} must be positive.");
+			}
+
+			mPrefetch = new PqsqlCopyPrefetch(mPGConn, PrefetchCount);
+		}
+
+		// installs chunk as current COPY data buffer, returns the result of PQgetCopyData for chunk
+		private int TakeChunk(PqsqlCopyPrefetch.Chunk chunk)
+		{
+			var buffer = Buffer;
+			if (buffer != IntPtr.Zero)
+			{
+				PqsqlWrapper.PQfreemem(buffer);
+			}
+
+			*((IntPtr*) mBufferPtr) = chunk.Data;
+			return chunk.Length;
+		}
+
+		// stops prefetching and releases all queued chunks
+		private void StopPrefetch()
+		{
+			if (mPrefetch == null)
+			{
+				return;
+			}
+
+			mPrefetch.Dispose();
+			mPrefetch = null;
+		}
+
+		#endregion
+
 		/// <summary>
 		/// Determines whether the next value is <c>null</c>. If it is <c>null</c> the
 		/// read cursor is advanced to the next value. Otherwise the read cursor stays put.
@@ -456,5 +726,325 @@ namespace Pqsql
 
 			throw new InvalidOperationException(errMsg);
 		}
+
+		#region batch interface
+
+		// initial size of the byte buffers for string and bytea columns in ReadBatch
+		private const int BatchBufferSize = 64 * 1024;
+
+		// returns the source type of column col for ReadBatch, checks that column can hold the values
+		private PqsqlDbType GetBatchColumnType(Array column, int col)
+		{
+			PqsqlDbType oid;
+
+			if (column is bool[])
+				oid = PqsqlDbType.Boolean;
+			else if (column is short[])
+				oid = PqsqlDbType.Int2;
+			else if (column is int[])
+				oid = PqsqlDbType.Int4;
+			else if (column is long[])
+				oid = PqsqlDbType.Int8;
+			else if (column is float[])
+				oid = PqsqlDbType.Float4;
+			else if (column is double[])
+				oid = PqsqlDbType.Float8;
+			else if (column is DateTime[])
+				oid = PqsqlDbType.Timestamp;
+			else if (column is string[])
+				oid = PqsqlDbType.Text;
+			else if (column is byte[][])
+				oid = PqsqlDbType.Bytea;
+			else
+				throw new ArgumentException($"Cannot read column {col} into {column.GetType()}", nameof(column));
+
+			// without schema information we trust the column arrays
+			PqsqlColInfo ci = mRowInfo?[col];
+			if (ci == null)
+				return oid;
+
+			switch (ci.Oid)
+			{
+			case PqsqlDbType.Oid when oid == PqsqlDbType.Int4:
+			case PqsqlDbType.TimestampTZ when oid == PqsqlDbType.Timestamp:
+			case PqsqlDbType.Date when oid == PqsqlDbType.Timestamp:
+			case PqsqlDbType.Varchar when oid == PqsqlDbType.Text:
+			case PqsqlDbType.BPChar when oid == PqsqlDbType.Text:
+			case PqsqlDbType.Name when oid == PqsqlDbType.Text:
+				return ci.Oid;
+			}
+
+			if (ci.Oid != oid)
+			{
+				throw new PqsqlException($"The type of column '{ci.ColumnName}' is '{ci.Oid}'. " +
+										 $"You cannot read an '{ci.Oid}' value into {column.GetType()}.");
+			}
+
+			return oid;
+		}
+
+		//
+		// Summary:
+		//     Reads the next rows into column-major arrays, decoding a whole batch of
+		//     rows with a single native call. columns[i] receives the values of the i-th column:
+		//     bool[] for boolean, short[] for int2, int[] for int4 and oid, long[] for int8,
+		//     float[] for float4, double[] for float8, DateTime[] for timestamp, timestamptz, and date,
+		//     string[] for text, varchar, bpchar, and name, and byte[][] for bytea columns.
+		//     NULL values are stored as default, or null for string[] and byte[][].
+		//     FetchRow must not be called after ReadBatch.
+		//
+		// Parameters:
+		//   columns:
+		//     The column arrays, all of the same length.
+		//
+		//   nullmaps:
+		//     If not null, each non-null nullmaps[i] receives a bitmap where bit j (least
+		//     significant bit first) is set iff row j of column i is NULL.
+		//
+		// Returns:
+		//     The number of rows read, 0 if the end of the COPY data has been reached.
+		public int ReadBatch(Array[] columns, byte[][] nullmaps = null)
+		{
+			if (mPGConn == IntPtr.Zero)
+				throw new InvalidOperationException("Connection is closed.");
+
+			if (columns == null)
+				throw new ArgumentNullException(nameof(columns));
+
+			if (mColumns == 0)
+				throw new InvalidOperationException($"{nameof(PqsqlCopyTo)}.{nameof(Start)} must be called before we can read data");
+
+			if (columns.Length != mColumns)
+				throw new ArgumentException("Number of column arrays must match number of columns " + mColumns, nameof(columns));
+
+			if (nullmaps != null && nullmaps.Length != mColumns)
+				throw new ArgumentException("Number of null bitmaps must match number of columns " + mColumns, nameof(nullmaps));
+
+			int nrows = columns[0]?.Length ?? 0;
+			PqsqlDbType[] oids = new PqsqlDbType[mColumns];
+			Array[] values = new Array[mColumns];
+			int[][] lens = new int[mColumns][];
+			byte[][] nulls = new byte[mColumns][];
+
+			for (int i = 0; i < mColumns; i++)
+			{
+				Array column = columns[i];
+
+				if (column == null)
+					throw new ArgumentNullException(nameof(columns), "Column array " + i + " is null");
+
+				if (column.Length != nrows)
+					throw new ArgumentException("Column arrays must have the same length", nameof(columns));
+
+				if (nullmaps?[i] != null && nullmaps[i].Length < (nrows + 7) / 8)
+					throw new ArgumentException("Null bitmap " + i + " too small", nameof(nullmaps));
+
+				oids[i] = GetBatchColumnType(column, i);
+				nulls[i] = nullmaps?[i];
+
+				// native vectors for types without a blittable managed representation
+				switch (oids[i])
+				{
+				case PqsqlDbType.Boolean:
+					values[i] = new byte[nrows];
+					break;
+				case PqsqlDbType.Timestamp:
+				case PqsqlDbType.TimestampTZ:
+					values[i] = new long[nrows];
+					nulls[i] = nulls[i] ?? new byte[(nrows + 7) / 8];
+					break;
+				case PqsqlDbType.Date:
+					values[i] = new int[nrows];
+					nulls[i] = nulls[i] ?? new byte[(nrows + 7) / 8];
+					break;
+				case PqsqlDbType.Text:
+				case PqsqlDbType.Varchar:
+				case PqsqlDbType.BPChar:
+				case PqsqlDbType.Name:
+				case PqsqlDbType.Bytea:
+					if (mBatchBuffers == null)
+						mBatchBuffers = new byte[mColumns][];
+					values[i] = mBatchBuffers[i] = mBatchBuffers[i] ?? new byte[BatchBufferSize];
+					lens[i] = new int[nrows];
+					break;
+				default:
+					values[i] = column;
+					break;
+				}
+			}
+
+			if (nrows == 0 || mCopyFinished)
+				return 0;
+
+			if (mPrefetch != null)
+				throw new InvalidOperationException($"{nameof(ReadBatch)} cannot be called after {nameof(FetchRowAsync)}.");
+
+			if (mReader == IntPtr.Zero)
+			{
+				// the reader continues after the rows retrieved with FetchRow
+				mReader = PqsqlBinaryFormat.pqcr_create(mPGConn, mColumns, mHeaderReceived ? 1 : 0);
+
+				if (mReader == IntPtr.Zero)
+					throw new PqsqlException("Cannot create COPY reader");
+			}
+
+			int n;
+
+			while ((n = GetRows(oids, values, lens, nulls, nrows)) == PqsqlBinaryFormat.PQCR_TOOSMALL)
+			{
+				// the next row does not fit, grow all variable-length column buffers
+				for (int i = 0; i < mColumns; i++)
+				{
+					if (lens[i] != null)
+						values[i] = mBatchBuffers[i] = new byte[2 * mBatchBuffers[i].Length];
+				}
+			}
+
+			if (n == PqsqlBinaryFormat.PQCR_ERROR)
+				throw new PqsqlException("The COPY operation received malformed data or unexpected column types.");
+
+			if (n < 0)
+				throw new PqsqlException(Error());
+
+			if (n == 0)
+			{
+				// we received the end trailer
+				FinishCopy();
+				return 0;
+			}
+
+			// convert native vectors into column arrays
+			for (int i = 0; i < mColumns; i++)
+			{
+				switch (oids[i])
+				{
+				case PqsqlDbType.Boolean:
+					bool[] bools = (bool[]) columns[i];
+					byte[] bs = (byte[]) values[i];
+					for (int j = 0; j < n; j++)
+					{
+						bools[j] = bs[j] != 0;
+					}
+					break;
+
+				case PqsqlDbType.Timestamp:
+				case PqsqlDbType.TimestampTZ:
+					DateTime[] dts = (DateTime[]) columns[i];
+					long[] ts = (long[]) values[i];
+					for (int j = 0; j < n; j++)
+					{
+						if ((nulls[i][j >> 3] & (1 << (j & 7))) != 0)
+							dts[j] = default(DateTime);
+						else
+							dts[j] = PqsqlBinaryFormat.GetDateTimeFromTimestamp(ts[j]);
+					}
+					break;
+
+				case PqsqlDbType.Date:
+					DateTime[] ds = (DateTime[]) columns[i];
+					int[] jdates = (int[]) values[i];
+					for (int j = 0; j < n; j++)
+					{
+						int jdate = jdates[j];
+
+						if ((nulls[i][j >> 3] & (1 << (j & 7))) != 0)
+							ds[j] = default(DateTime);
+						else if (jdate == int.MinValue) // date '-infinity'
+							ds[j] = DateTime.MinValue;
+						else if (jdate == int.MaxValue) // date 'infinity'
+							ds[j] = DateTime.MaxValue;
+						else
+							ds[j] = PqsqlBinaryFormat.GetDateTimeFromJDate(jdate);
+					}
+					break;
+
+				case PqsqlDbType.Bytea:
+					byte[][] blobs = (byte[][]) columns[i];
+					int bpos = 0;
+					for (int j = 0; j < n; j++)
+					{
+						int len = lens[i][j];
+						if (len < 0)
+						{
+							blobs[j] = null;
+							continue;
+						}
+
+						blobs[j] = new byte[len];
+						System.Buffer.BlockCopy(mBatchBuffers[i], bpos, blobs[j], 0, len);
+						bpos += len;
+					}
+					break;
+
+				case PqsqlDbType.Text:
+				case PqsqlDbType.Varchar:
+				case PqsqlDbType.BPChar:
+				case PqsqlDbType.Name:
+					string[] strs = (string[]) columns[i];
+					int spos = 0;
+					for (int j = 0; j < n; j++)
+					{
+						int len = lens[i][j];
+						if (len < 0)
+						{
+							strs[j] = null;
+							continue;
+						}
+
+						strs[j] = Encoding.UTF8.GetString(mBatchBuffers[i], spos, len);
+						spos += len;
+					}
+					break;
+				}
+			}
+
+			return n;
+		}
+
+		// pins values, lens, and nulls and decodes up to nrows rows using mReader
+		private int GetRows(PqsqlDbType[] oids, Array[] values, int[][] lens, byte[][] nulls, int nrows)
+		{
+			GCHandle[] handles = new GCHandle[3 * mColumns];
+
+			try
+			{
+				PqsqlBinaryFormat.pqcopy_vector[] cols = new PqsqlBinaryFormat.pqcopy_vector[mColumns];
+
+				for (int i = 0; i < mColumns; i++)
+				{
+					handles[3 * i] = GCHandle.Alloc(values[i], GCHandleType.Pinned);
+					cols[i].oid = (uint) oids[i];
+					cols[i].values = (void*) handles[3 * i].AddrOfPinnedObject();
+
+					if (lens[i] != null)
+					{
+						handles[3 * i + 1] = GCHandle.Alloc(lens[i], GCHandleType.Pinned);
+						cols[i].lens = (int*) handles[3 * i + 1].AddrOfPinnedObject();
+						cols[i].cap = (UIntPtr) values[i].Length;
+					}
+
+					if (nulls[i] != null)
+					{
+						handles[3 * i + 2] = GCHandle.Alloc(nulls[i], GCHandleType.Pinned);
+						cols[i].nullmap = (byte*) handles[3 * i + 2].AddrOfPinnedObject();
+					}
+				}
+
+				fixed (PqsqlBinaryFormat.pqcopy_vector* c = cols)
+				{
+					return PqsqlBinaryFormat.pqcr_get_rows(mReader, c, mColumns, nrows);
+				}
+			}
+			finally
+			{
+				foreach (GCHandle h in handles)
+				{
+					if (h.IsAllocated)
+						h.Free();
+				}
+			}
+		}
+
+		#endregion
 	}
 }
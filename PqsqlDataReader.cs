@@ -9,6 +9,8 @@ using System.Diagnostics.Contracts;
 #endif
 using System.Globalization;
 using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
 
 using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
 using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
@@ -80,6 +82,10 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 		/// </summary>
 		readonly PqsqlCommand mCmd;
 
+		// completed tasks of ReadAsync() for rows available without waiting
+		static readonly Task<bool> TrueTask = Task.FromResult(true);
+		static readonly Task<bool> FalseTask = Task.FromResult(false);
+
 		// fixed connection
 		readonly PqsqlConnection mConn;
 		// once mConn is ConnectionState.Open, we set mPGConn
@@ -119,6 +125,12 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 
 		bool mIsInSingleRowMode;
 
+		// all statements have been sent in pipeline mode, NextResult() consumes their results in order
+		bool mPipelined;
+
+		// the NULL result of the current statement has been received
+		bool mResultsConsumed;
+
 #if CODECONTRACTS
 		[ContractInvariantMethod]
 		private void ClassInvariant()
@@ -376,6 +388,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				return;
 
 			Consume(); // consume remaining results
+			FinishPipeline(); // skip results of remaining statements
 
 			if ((mBehaviour & CommandBehavior.CloseConnection) > 0)
 			{
@@ -399,13 +412,46 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				return;
 
 			// consume all remaining results until we reach the NULL result
-			while ((mResult = PqsqlWrapper.PQgetResult(mPGConn)) != IntPtr.Zero)
+			while ((mResult = GetResult()) != IntPtr.Zero)
 			{
 				// always free mResult
 				PqsqlWrapper.PQclear(mResult);
 			}
 		}
 
+		// fetch the next result of the current statement
+		private IntPtr GetResult()
+		{
+			// in pipeline mode, the next result after the NULL result belongs to the next statement
+			if (mPipelined && mResultsConsumed)
+				return IntPtr.Zero;
+
+			IntPtr res = PqsqlWrapper.PQgetResult(mPGConn);
+
+			if (res == IntPtr.Zero)
+			{
+				mResultsConsumed = true;
+
+				if (mPipelined && mStmtNum >= mMaxStmt - 1)
+				{
+					FinishPipeline(); // last statement done, leave pipeline mode
+				}
+			}
+
+			return res;
+		}
+
+		// consume the results of all remaining statements up to the pipeline sync and leave pipeline mode
+		private void FinishPipeline()
+		{
+			if (!mPipelined || mPGConn == IntPtr.Zero)
+				return;
+
+			mPipelined = false;
+			PqsqlUtils.FinishPipeline(mPGConn, mResultsConsumed);
+			mResultsConsumed = true;
+		}
+
 
 		#region Dispose
 
@@ -600,6 +646,12 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 
 
 		internal static Array GetArrayFill(IntPtr res, int row, int ordinal, PqsqlDbType typoid, Type nullable, Type nonNullable, Func<IntPtr, int, object> itemDelegate)
+		{
+			return GetArrayFill(res, row, ordinal, typoid, nullable, nonNullable, itemDelegate, 0);
+		}
+
+		// itemSize > 0: arrays without NULL values are decoded in one native call into the pinned nonNullable array
+		internal static Array GetArrayFill(IntPtr res, int row, int ordinal, PqsqlDbType typoid, Type nullable, Type nonNullable, Func<IntPtr, int, object> itemDelegate, int itemSize)
 		{
 			int ndim;
 			int flags;
@@ -627,6 +679,26 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			Contract.Assert(ndim == 1); // Arrays with ndim != 1 not supported yet
 #endif
 
+			if (flags == 0 && itemSize > 0)
+			{
+				int n;
+				GCHandle h = GCHandle.Alloc(a, GCHandleType.Pinned);
+
+				try
+				{
+					n = PqsqlBinaryFormat.pqbf_get_array_values(val, a.Length, itemSize, h.AddrOfPinnedObject());
+				}
+				finally
+				{
+					h.Free();
+				}
+
+				if (n == a.Length)
+					return a;
+
+				// item length mismatch, fall back to item-wise decoding
+			}
+
 			FillArray(ref a, val, ndim, (x, len) => itemDelegate(x, len));
 
 			return a;
@@ -1143,10 +1215,34 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			Contract.Assume(ordinal < mRowInfo.Length);
 #endif
 
-			return (decimal) GetNumeric(mResult, mRowNum, ordinal, mRowInfo[ordinal].Modifier);
+			return GetDecimal(mResult, mRowNum, ordinal);
+		}
+
+		internal static decimal GetDecimal(IntPtr res, int row, int ordinal)
+		{
+			return GetDecimal(PqsqlWrapper.PQgetvalue(res, row, ordinal));
+		}
+
+		// decodes the binary numeric value v, also used for the items of numeric arrays
+		internal static decimal GetDecimal(IntPtr v)
+		{
+			uint lo;
+			uint mid;
+			uint hi;
+			int scale;
+			int sign;
+
+			int ret = PqsqlBinaryFormat.pqbf_get_decimal(v, out lo, out mid, out hi, out scale, out sign);
+
+			if (ret == 0)
+				throw new OverflowException("Numeric value NaN or Infinity cannot be represented as Decimal");
+			if (ret < 0)
+				throw new OverflowException("Numeric value was either too large or too small for a Decimal");
+
+			return PqsqlBinaryFormat.GetDecimal(lo, mid, hi, scale, sign);
 		}
 
-		// TODO double loses precision, should we get the string representation of the numeric here?
+		// double loses precision, use GetDecimal for exact values
 		internal static double GetNumeric(IntPtr res, int row, int ordinal, int typmod)
 		{
 			IntPtr v = PqsqlWrapper.PQgetvalue(res, row, ordinal);
@@ -1967,6 +2063,50 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 		// Returns:
 		//     true if there are more result sets; otherwise false.
 		public override bool NextResult()
+		{
+			if (!ExecuteNextStatement())
+				return false;
+
+			return ReadFirstRow();
+		}
+
+		//
+		// Summary:
+		//     Asynchronously advances the reader to the next result. The statement is sent
+		//     in non-blocking mode and no thread is blocked while waiting for its result.
+		//     Preparing the statement (PqsqlCommand.Prepare() or automatic preparation)
+		//     and evicting prepared statements still wait synchronously for the server.
+		//
+		// Returns:
+		//     true if there are more result sets; otherwise false.
+		public override async Task<bool> NextResultAsync(CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			// finished with all query statements or no connection open yet
+			if (mStmtNum >= mMaxStmt - 1 || mPGConn == IntPtr.Zero)
+				return false;
+
+			// PQsendQueryParams() and friends queue the statement without blocking on a full socket buffer
+			PqsqlWrapper.PQsetnonblocking(mPGConn, 1);
+
+			try
+			{
+				ExecuteNextStatement();
+				await PqsqlSocketWaiter.FlushAsync(mPGConn, cancellationToken).ConfigureAwait(false);
+			}
+			finally
+			{
+				PqsqlWrapper.PQsetnonblocking(mPGConn, 0);
+			}
+
+			await WaitForResultAsync(cancellationToken).ConfigureAwait(false);
+
+			return ReadFirstRow();
+		}
+
+		// execute the next statement, or in pipeline mode continue with the results of the next statement
+		private bool ExecuteNextStatement()
 		{
 			// finished with all query statements or no connection open yet
 			if (mStmtNum >= mMaxStmt - 1 || mPGConn == IntPtr.Zero)
@@ -1978,16 +2118,39 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			Contract.Assert(mPGConn != IntPtr.Zero);
 #endif
 
+			if (mPipelined)
+			{
+				Consume(); // skip remaining results of the current statement
+			}
+
 			mStmtNum++; // set next statement
 			mPopulateAndFill = true; // next Read() below will get fresh row information
+			mResultsConsumed = false;
 
 #if CODECONTRACTS
 			Contract.Assert(mStmtNum >= 0);
 			Contract.Assert(mStmtNum < mStatements.Length);
 #endif
 
-			// TODO when we have query pipelining, we might be able to send all statements at once https://commitfest.postgresql.org/10/634/ http://2ndquadrant.github.io/postgres/libpq-batch-mode.html
-			if (Execute() == false)
+			bool executed;
+
+			if (mPipelined)
+			{
+				// statement has already been sent, its results follow the results of the former statement
+				SetResultMode(mStatements[mStmtNum]);
+				executed = true;
+			}
+			else if (mStmtNum == 0 && mMaxStmt > 1 && (mBehaviour & CommandBehavior.SchemaOnly) == 0 && mConn.PipelineMode)
+			{
+				// send all statements at once
+				executed = ExecutePipeline();
+			}
+			else
+			{
+				executed = Execute();
+			}
+
+			if (!executed)
 			{
 				string err = mConn.GetErrorMessage();
 				throw new PqsqlException("Could not execute statement «" + mStatements[mStmtNum] + "»: " + err);
@@ -1996,6 +2159,12 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			// start with a new result set
 			Reset();
 
+			return true;
+		}
+
+		// read the first row of the current statement
+		private bool ReadFirstRow()
+		{
 			if (!Read())
 			{
 				// in case an intermediate result set is empty
@@ -2006,6 +2175,67 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			return true;
 		}
 
+		//
+		// Summary:
+		//     Asynchronously advances the reader to the next record in a result set. Rows
+		//     of the current result buffer are returned synchronously, otherwise no thread
+		//     is blocked while waiting for the next result.
+		//
+		// Returns:
+		//     true if there are more rows; otherwise false.
+		public override Task<bool> ReadAsync(CancellationToken cancellationToken)
+		{
+			if (cancellationToken.IsCancellationRequested)
+				return Task.FromCanceled<bool>(cancellationToken);
+
+			if (ReadWouldBlock())
+				return ReadAsyncCore(cancellationToken);
+
+			try
+			{
+				return Read() ? TrueTask : FalseTask;
+			}
+			catch (Exception e)
+			{
+				return Task.FromException<bool>(e);
+			}
+		}
+
+		private async Task<bool> ReadAsyncCore(CancellationToken cancellationToken)
+		{
+			await WaitForResultAsync(cancellationToken).ConfigureAwait(false);
+			return Read();
+		}
+
+		// true if Read() has to wait for the next result from the server
+		private bool ReadWouldBlock()
+		{
+			if (mMaxStmt == 0 || mStmtNum == -1 || mPGConn == IntPtr.Zero)
+				return false;
+
+			if (!mPopulateAndFill && mRowNum + 1 < mMaxRows) // next row is in mResult
+				return false;
+
+			if (mPipelined && mResultsConsumed)
+				return false;
+
+			return PqsqlSocketWaiter.IsBusy(mPGConn);
+		}
+
+		// wait until PQgetResult() does not block, cancel the running statement if cancellationToken is cancelled
+		private async Task WaitForResultAsync(CancellationToken cancellationToken)
+		{
+			try
+			{
+				await PqsqlSocketWaiter.ConsumeInputAsync(mPGConn, cancellationToken).ConfigureAwait(false);
+			}
+			catch (OperationCanceledException)
+			{
+				mCmd.Cancel(); // Close() consumes the remaining results
+				throw;
+			}
+		}
+
 		//
 		// Summary:
 		//     Advances the reader to the next record in a result set.
@@ -2031,7 +2261,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				}
 
 				// fetch the next tuple(s)
-				mResult = PqsqlWrapper.PQgetResult(mPGConn);
+				mResult = GetResult();
 
 				// rewind mResult indexes
 				mRowNum = mRowNum > -1 ? 0 : -1;
@@ -2049,6 +2279,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				if (s == ExecStatusType.PGRES_COMMAND_OK)
 				{
 					mRecordsAffected = GetCmdTuples(s);
+					mConn.TrackSessionState(mResult);
 
 					// nothing to do, we just executed a command without result rows
 					Consume(); // consume remaining results
@@ -2060,13 +2291,20 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				// error handling
 				//
 
-				if (s != ExecStatusType.PGRES_SINGLE_TUPLE && s != ExecStatusType.PGRES_TUPLES_OK)
+				if (s != ExecStatusType.PGRES_SINGLE_TUPLE && s != ExecStatusType.PGRES_TUPLES_CHUNK && s != ExecStatusType.PGRES_TUPLES_OK)
 				{
 					string err = mConn.GetErrorMessage();
 					PqsqlException ex = new PqsqlException(err, mResult);
 
 					Consume(); // consume remaining results
 
+					if (mPipelined)
+					{
+						// all remaining statements of the pipeline have been aborted
+						FinishPipeline();
+						mStmtNum = mMaxStmt - 1;
+					}
+
 					throw ex;
 				}
 
@@ -2077,6 +2315,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 				if (mMaxRows == -1) // get number of tuples in a fresh result buffer
 				{
 					mMaxRows = PqsqlWrapper.PQntuples(mResult); // TODO what if we have more than 2^31 tuples?
+					mConn.TrackSessionState(mResult);
 				}
 
 				// first row of current statement => get column information and fill output parameters
@@ -2110,7 +2349,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 
 				// fetch the last result to clean up internal libpq state
 				PqsqlWrapper.PQclear(mResult);
-				mResult = PqsqlWrapper.PQgetResult(mPGConn);
+				mResult = GetResult();
 			}
 
 			// result buffer exhausted, this was the last result of the current query
@@ -2120,6 +2359,273 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 
 		#endregion
 
+		#region columnar access to the current result buffer
+
+		//
+		// Summary:
+		//     Gets the number of rows in the current result buffer, starting with the
+		//     current row. The GetColumn() methods decode at most this number of rows,
+		//     and Read() advances through these rows without fetching a new result.
+		public int BufferedRowCount
+		{
+			get
+			{
+				if (mResult == IntPtr.Zero || mRowNum < 0 || mRowNum >= mMaxRows)
+					return 0;
+
+				return mMaxRows - mRowNum;
+			}
+		}
+
+		// checks ordinal, values, and nullmap and returns the number of rows to decode with GetColumn()
+		private int CheckColumn(int ordinal, PqsqlDbType type, Array values, int valuesOffset, byte[] nullmap)
+		{
+			CheckBounds(ordinal);
+
+			if (mRowNum < 0 || mRowNum >= mMaxRows)
+				throw new InvalidOperationException("No tuple available");
+
+			if (type != mRowInfo[ordinal].Oid)
+				throw new PqsqlException("Row datatype accessed with wrong datatype", (int) PqsqlState.DATATYPE_MISMATCH);
+
+			if (values == null)
+				throw new ArgumentNullException(nameof(values));
+
+			if (valuesOffset < 0 || valuesOffset > values.Length)
+				throw new ArgumentOutOfRangeException(nameof(valuesOffset));
+
+			int nrows = Math.Min(mMaxRows - mRowNum, values.Length - valuesOffset);
+
+			if (nullmap != null && nullmap.Length < (nrows + 7) / 8)
+				throw new ArgumentException("Null bitmap too small", nameof(nullmap));
+
+			return nrows;
+		}
+
+		private void CheckColumnDecoded(int ordinal, int n)
+		{
+			if (n < 0)
+				throw new PqsqlException(string.Format(CultureInfo.InvariantCulture, "Could not decode column {0}", ordinal), (int) PqsqlState.DATATYPE_MISMATCH);
+		}
+
+		//
+		// Summary:
+		//     Decodes the specified column of all rows in the current result buffer,
+		//     starting with the current row, using a single native call.
+		//
+		// Parameters:
+		//   ordinal:
+		//     The zero-based column ordinal.
+		//
+		//   values:
+		//     The array receiving the column values, NULL values are stored as default.
+		//
+		//   valuesOffset:
+		//     The index within values where the first value will be stored.
+		//
+		//   nullmap:
+		//     If not null, bit i (least significant bit first) of nullmap is set iff
+		//     values[valuesOffset + i] is NULL.
+		//
+		// Returns:
+		//     The number of decoded rows, i.e., Math.Min(BufferedRowCount, values.Length - valuesOffset).
+		public int GetColumn(int ordinal, bool[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Boolean, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (bool* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_bool(mResult, ordinal, mRowNum, nrows, (byte*) v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		public int GetColumn(int ordinal, short[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Int2, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (short* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_int2(mResult, ordinal, mRowNum, nrows, v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		public int GetColumn(int ordinal, int[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Int4, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (int* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_int4(mResult, ordinal, mRowNum, nrows, v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		public int GetColumn(int ordinal, long[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Int8, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (long* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_int8(mResult, ordinal, mRowNum, nrows, v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		public int GetColumn(int ordinal, float[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Float4, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (float* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_float4(mResult, ordinal, mRowNum, nrows, v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		public int GetColumn(int ordinal, double[] values, int valuesOffset, byte[] nullmap)
+		{
+			int nrows = CheckColumn(ordinal, PqsqlDbType.Float8, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			unsafe
+			{
+				fixed (double* v = &values[valuesOffset])
+				fixed (byte* nm = nullmap)
+				{
+					nrows = PqsqlBinaryFormat.pqbf_decode_column_float8(mResult, ordinal, mRowNum, nrows, v, nm);
+				}
+			}
+
+			CheckColumnDecoded(ordinal, nrows);
+			return nrows;
+		}
+
+		// timestamp, timestamptz, and date columns
+		public int GetColumn(int ordinal, DateTime[] values, int valuesOffset, byte[] nullmap)
+		{
+			CheckBounds(ordinal);
+
+			PqsqlDbType oid = mRowInfo[ordinal].Oid;
+
+			if (oid != PqsqlDbType.Timestamp && oid != PqsqlDbType.TimestampTZ && oid != PqsqlDbType.Date)
+				throw new PqsqlException("Row datatype accessed with wrong datatype", (int) PqsqlState.DATATYPE_MISMATCH);
+
+			int nrows = CheckColumn(ordinal, oid, values, valuesOffset, nullmap);
+
+			if (nrows == 0)
+				return 0;
+
+			// we need the NULL bitmap to store NULL values as default(DateTime)
+			if (nullmap == null)
+				nullmap = new byte[(nrows + 7) / 8];
+
+			if (oid == PqsqlDbType.Date)
+			{
+				int[] jdates = new int[nrows];
+
+				unsafe
+				{
+					fixed (int* v = jdates)
+					fixed (byte* nm = nullmap)
+					{
+						nrows = PqsqlBinaryFormat.pqbf_decode_column_date(mResult, ordinal, mRowNum, nrows, v, nm);
+					}
+				}
+
+				CheckColumnDecoded(ordinal, nrows);
+
+				for (int i = 0; i < nrows; i++)
+				{
+					int jdate = jdates[i];
+
+					if ((nullmap[i >> 3] & (1 << (i & 7))) != 0)
+						values[valuesOffset + i] = default(DateTime);
+					else if (jdate == int.MinValue) // date '-infinity'
+						values[valuesOffset + i] = DateTime.MinValue;
+					else if (jdate == int.MaxValue) // date 'infinity'
+						values[valuesOffset + i] = DateTime.MaxValue;
+					else
+						values[valuesOffset + i] = PqsqlBinaryFormat.GetDateTimeFromJDate(jdate);
+				}
+			}
+			else
+			{
+				long[] timestamps = new long[nrows];
+
+				unsafe
+				{
+					fixed (long* v = timestamps)
+					fixed (byte* nm = nullmap)
+					{
+						nrows = PqsqlBinaryFormat.pqbf_decode_column_timestamp(mResult, ordinal, mRowNum, nrows, v, nm);
+					}
+				}
+
+				CheckColumnDecoded(ordinal, nrows);
+
+				for (int i = 0; i < nrows; i++)
+				{
+					if ((nullmap[i >> 3] & (1 << (i & 7))) != 0)
+						values[valuesOffset + i] = default(DateTime);
+					else
+						values[valuesOffset + i] = PqsqlBinaryFormat.GetDateTimeFromTimestamp(timestamps[i]);
+				}
+			}
+
+			return nrows;
+		}
+
+		#endregion
+
 		#region query metadata retrieval
 
 		/// <summary>
@@ -2131,6 +2637,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			switch (s)
 			{
 				case ExecStatusType.PGRES_SINGLE_TUPLE: // SELECT
+				case ExecStatusType.PGRES_TUPLES_CHUNK:
 				case ExecStatusType.PGRES_TUPLES_OK:
 					return -1;
 
@@ -2216,7 +2723,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 #endif
 
 				// try to lookup OID, otherwise try to guess type and fetch type specs from DB
-				PqsqlTypeRegistry.PqsqlTypeValue tv = PqsqlTypeRegistry.GetOrAdd(oid, mConn);
+				PqsqlTypeRegistry.PqsqlTypeValue tv = PqsqlTypeRegistry.GetOrAdd(oid, mConn.ConnectionString);
 
 #if CODECONTRACTS
 				Contract.Assert(tv != null);
@@ -2257,7 +2764,7 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 		}
 
 		/// <summary>
-		/// executes the next statement with PQsendQueryParams
+		/// executes the next statement with PQsendQueryParams, or with PQsendQueryPrepared if mCmd is prepared
 		/// </summary>
 		/// <returns>true if and only if current statement was successfully executed</returns>
 		private bool Execute()
@@ -2270,7 +2777,6 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 #endif
 
 			string stmt = mStatements[mStmtNum]; // current statement
-			CommandBehavior behave = mBehaviour; // result fetching behaviour
 
 			// convert query string to utf8
 			byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
@@ -2278,35 +2784,131 @@ WHERE NOT ca.attisdropped AND ca.attnum > 0 AND ca.attrelid=:o;";
 			if (utf8query == null || utf8query[0] == 0x0) // null or empty string
 				return false;
 
-			// create query parameters and send query
-			using (PqsqlParameterBuffer pbuf = new PqsqlParameterBuffer(mCmd.Parameters))
+			// create query parameters in the reusable parameter buffer of mCmd and send query
+			PqsqlParameterBuffer pbuf = mCmd.GetParameterBuffer();
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			num_param = pbuf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+			byte[] name;
+
+			if (!mCmd.LookupStatement(stmt, utf8query, num_param, ptyps, out name))
+				return false;
+
+			if (!mCmd.SendStatement(stmt, utf8query, name, num_param, ptyps, pvals, plens, pfrms))
+				return false;
+
+			return SetResultMode(stmt);
+		}
+
+		/// <summary>
+		/// sends all statements with a single pipeline sync in libpq pipeline mode, NextResult() then
+		/// consumes their results in order. The statements run in an implicit transaction up to the
+		/// sync unless an explicit transaction is active, and a failing statement aborts the others.
+		/// </summary>
+		/// <returns>true if and only if all statements were successfully sent</returns>
+		private bool ExecutePipeline()
+		{
+			PqsqlParameterBuffer pbuf = mCmd.GetParameterBuffer();
+			int num_param;
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			num_param = pbuf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+			byte[][] utf8queries = new byte[mMaxStmt][];
+			byte[][] names = new byte[mMaxStmt][];
+
+			PqsqlPreparedStatementCache cache = mConn.StatementCache;
+			int evictions = cache.Evictions;
+			bool dropped = false;
+
+			// prepared statements must be created before we enter pipeline mode
+			for (int i = 0; i < mMaxStmt; i++)
 			{
-				int num_param;
-				IntPtr ptyps; // oid*
-				IntPtr pvals; // char**
-				IntPtr plens; // int*
-				IntPtr pfrms; // int*
+				string stmt = mStatements[i];
+				byte[] utf8query = PqsqlUTF8Statement.CreateUTF8Statement(stmt);
 
-				num_param = pbuf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+				if (utf8query == null || utf8query[0] == 0x0) // null or empty string
+				{
+					mStmtNum = i;
+					return false;
+				}
 
-				unsafe
+				utf8queries[i] = utf8query;
+
+				// statements following DISCARD ALL or DEALLOCATE cannot rely on prepared statements
+				if (!dropped && !mCmd.LookupStatement(stmt, utf8query, num_param, ptyps, out names[i]))
 				{
-					fixed (byte* pq = utf8query)
-					{
-						if (PqsqlWrapper.PQsendQueryParams(mPGConn, pq, num_param, ptyps, pvals, plens, pfrms, 1) == 0)
-							return false;
-					}
+					mStmtNum = i;
+					return false;
+				}
+
+				dropped |= PqsqlCommand.DropsPreparedStatements(stmt);
+			}
+
+			// a later statement evicted the prepared statement of a former statement
+			if (cache.Evictions != evictions)
+			{
+				Array.Clear(names, 0, mMaxStmt);
+			}
+
+			if (PqsqlWrapper.PQenterPipelineMode(mPGConn) == 0)
+				return false;
+
+			mPipelined = true;
+
+			for (int i = 0; i < mMaxStmt; i++)
+			{
+				if (!mCmd.SendStatement(mStatements[i], utf8queries[i], names[i], num_param, ptyps, pvals, plens, pfrms))
+				{
+					PqsqlWrapper.PQpipelineSync(mPGConn); // let FinishPipeline() consume the results sent so far
+					mStmtNum = i;
+					return false;
 				}
 			}
 
+			if (PqsqlWrapper.PQpipelineSync(mPGConn) == 0)
+				return false;
+
+			SetResultMode(mStatements[0]);
+
+			return true;
+		}
+
+		// fetch results of stmt row by row, or in chunks of rows if result_chunk_size is set
+		private bool SetResultMode(string stmt)
+		{
+			mIsInSingleRowMode = false;
+
 			// libpq does not want PQsetSingleRowMode with cursors, don't enable it for fetch statements
-			if (!stmt.StartsWith("fetch ", StringComparison.OrdinalIgnoreCase))
+			if (stmt.StartsWith("fetch ", StringComparison.OrdinalIgnoreCase))
+				return true;
+
+			// small result sets: read one fully materialized PGresult
+			if (mCmd.BufferedResults || (mBehaviour & CommandBehavior.SingleRow) == CommandBehavior.SingleRow)
+				return true;
+
+			int chunkSize = mConn.ResultChunkSize;
+
+			if (chunkSize > 0)
 			{
-				if (PqsqlWrapper.PQsetSingleRowMode(mPGConn) == 0)
+				// results arrive as PGRES_TUPLES_CHUNK with up to chunkSize rows each
+				if (PqsqlWrapper.PQsetChunkedRowsMode(mPGConn, chunkSize) == 0)
 					return false;
-				mIsInSingleRowMode = true;
+			}
+			else if (PqsqlWrapper.PQsetSingleRowMode(mPGConn) == 0)
+			{
+				return false;
 			}
 
+			mIsInSingleRowMode = true;
 			return true;
 		}
 
@@ -0,0 +1,393 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
+
+namespace Pqsql
+{
+	/// <summary>
+	/// sends the commands of many PqsqlConnection objects over a few pooled connections. Each
+	/// command is appended with PQsendQueryParams and PQpipelineSync to the libpq pipeline of the
+	/// shared connection with the fewest pending commands, so it runs in its own implicit transaction.
+	/// Results are read when the socket becomes readable and handed to the waiting commands in the
+	/// order the commands have been sent.
+	/// </summary>
+	internal sealed class PqsqlMultiplexer
+	{
+		/// <summary>
+		/// a command sent to a shared connection, waiting for its result
+		/// </summary>
+		private sealed class Request
+		{
+			// completed with the first result of the command, failed if the connection broke
+			public readonly TaskCompletionSource<IntPtr> Completion = new TaskCompletionSource<IntPtr>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+			// first result of the command, further results are cleared
+			public IntPtr Result;
+		}
+
+		/// <summary>
+		/// a pooled connection in pipeline mode, guarded by lock (SharedConnection)
+		/// </summary>
+		private sealed class SharedConnection
+		{
+			// PGconn*, IntPtr.Zero until the first command is sent or after the connection broke
+			public IntPtr PGConn;
+
+			// sent commands in the order of their results
+			public readonly Queue<Request> Pending = new Queue<Request>();
+
+			// number of entries in Pending, read without taking the lock
+			public int PendingCount;
+
+			// true while we wait for the socket of PGConn to become readable
+			public bool Reading;
+
+			// number of consecutive NULL results
+			public int Nulls;
+
+			// cancels the socket wait of PGConn, replaced whenever PGConn is closed
+			public CancellationTokenSource Cancel = new CancellationTokenSource();
+		}
+
+		// the connections are taken from this pool and never released
+		private readonly PqsqlConnectionPool.ConnectionPool mPool;
+
+		private readonly SharedConnection[] mConnections;
+
+		public PqsqlMultiplexer(PqsqlConnectionPool.ConnectionPool pool, int connections)
+		{
+			mPool = pool;
+			mConnections = new SharedConnection[connections];
+
+			for (int i = 0; i < connections; i++)
+			{
+				mConnections[i] = new SharedConnection();
+			}
+		}
+
+		// Summary:
+		//     Sends utf8query with the num_param parameters in ptyps, pvals, plens, and pfrms
+		//     (see PqsqlParameterBuffer.GetQueryParams) to the shared connection with the
+		//     fewest pending commands. The parameters have been copied by libpq once
+		//     Execute returns. A shared connection is taken from the pool with GetPGConn,
+		//     so the caller might be blocked up to connect_timeout.
+		//
+		// Returns:
+		//     A task completed with the first result of the command, which must be freed
+		//     with PQclear.
+		public Task<IntPtr> Execute(byte[] utf8query, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms)
+		{
+			SharedConnection c = Pick();
+			Request r = new Request();
+
+			// a connection we took from mPool for c
+			IntPtr conn = IntPtr.Zero;
+			PqsqlPreparedStatementCache statements = null;
+
+			try
+			{
+				// GetPGConn() might wait up to connect_timeout for a pooled connection,
+				// so we must not hold the lock of c meanwhile
+				while (!TrySend(c, r, ref conn, utf8query, num_param, ptyps, pvals, plens, pfrms))
+				{
+					ConnStatusType connStatus;
+					PGTransactionStatusType tranStatus;
+
+					IntPtr pgconn = PqsqlConnectionPool.GetPGConn(mPool, out statements, out connStatus, out tranStatus);
+					conn = EnterPipeline(pgconn, connStatus, tranStatus);
+				}
+			}
+			finally
+			{
+				Release(conn, statements);
+			}
+
+			return r.Completion.Task;
+		}
+
+		// Summary:
+		//     Like Execute, but a shared connection is taken from the pool with
+		//     GetPGConnAsync. The parameters must not be changed until the returned
+		//     task has completed.
+		//
+		// Returns:
+		//     A task completed with the first result of the command, which must be freed
+		//     with PQclear.
+		public async Task<IntPtr> ExecuteAsync(byte[] utf8query, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms, CancellationToken cancellationToken)
+		{
+			SharedConnection c = Pick();
+			Request r = new Request();
+
+			// a connection we took from mPool for c
+			IntPtr conn = IntPtr.Zero;
+			PqsqlPreparedStatementCache statements = null;
+
+			try
+			{
+				while (!TrySend(c, r, ref conn, utf8query, num_param, ptyps, pvals, plens, pfrms))
+				{
+					PqsqlConnectionPool.ConnectionInfo info = await PqsqlConnectionPool.GetPGConnAsync(mPool, mPool.ConnectTimeout, cancellationToken).ConfigureAwait(false);
+					statements = info.statements;
+
+					PGTransactionStatusType tranStatus;
+					ConnStatusType connStatus = PqsqlConnectionPool.GetStatus(info.pgconn, out tranStatus);
+					conn = EnterPipeline(info.pgconn, connStatus, tranStatus);
+				}
+			}
+			finally
+			{
+				Release(conn, statements);
+			}
+
+			return await r.Completion.Task.ConfigureAwait(false);
+		}
+
+		// send the command of r with c, c adopts conn unless it is connected already.
+		// false if neither c nor conn are connected
+		private bool TrySend(SharedConnection c, Request r, ref IntPtr conn, byte[] utf8query, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms)
+		{
+			lock (c)
+			{
+				if (c.PGConn == IntPtr.Zero && conn != IntPtr.Zero)
+				{
+					c.PGConn = conn;
+					conn = IntPtr.Zero;
+				}
+
+				if (c.PGConn == IntPtr.Zero)
+					return false;
+
+				Send(c, r, utf8query, num_param, ptyps, pvals, plens, pfrms);
+				return true;
+			}
+		}
+
+		// give back conn to mPool if another command connected the shared connection in the meantime
+		private void Release(IntPtr conn, PqsqlPreparedStatementCache statements)
+		{
+			if (conn == IntPtr.Zero)
+				return;
+
+			PqsqlWrapper.PQexitPipelineMode(conn);
+			PqsqlConnectionPool.ReleasePGConn(mPool, conn, statements, false);
+		}
+
+		// append the command of r to the pipeline of c, called with the lock of c held
+		private void Send(SharedConnection c, Request r, byte[] utf8query, int num_param, IntPtr ptyps, IntPtr pvals, IntPtr plens, IntPtr pfrms)
+		{
+			int sent;
+
+			unsafe
+			{
+				fixed (byte* pq = utf8query)
+				{
+					sent = PqsqlWrapper.PQsendQueryParams(c.PGConn, pq, num_param, ptyps, pvals, plens, pfrms, 1);
+				}
+			}
+
+			if (sent == 0 && PqsqlWrapper.PQstatus(c.PGConn) == ConnStatusType.CONNECTION_OK)
+			{
+				// libpq rejected the command before sending it, the pipeline is still intact
+				throw new PqsqlException("Could not send statement: " + PqsqlUtils.GetErrorMessage(c.PGConn));
+			}
+
+			if (sent == 0 || PqsqlWrapper.PQpipelineSync(c.PGConn) == 0)
+			{
+				string err = PqsqlUtils.GetErrorMessage(c.PGConn);
+				Fail(c, err);
+				throw new PqsqlException("Could not send statement: " + err, (int) PqsqlState.CONNECTION_FAILURE);
+			}
+
+			c.Pending.Enqueue(r);
+			Volatile.Write(ref c.PendingCount, c.Pending.Count);
+
+			// libpq reads input while the output does not fit into the socket buffer,
+			// so some results might not show up as readable socket anymore
+			if (!Receive(c))
+			{
+				Fail(c, PqsqlUtils.GetErrorMessage(c.PGConn));
+			}
+			else
+			{
+				Arm(c);
+			}
+		}
+
+		// Summary:
+		//     Closes the shared connections without pending commands, see PqsqlConnectionPool.Clear().
+		public void Clear()
+		{
+			foreach (SharedConnection c in mConnections)
+			{
+				lock (c)
+				{
+					if (c.PGConn != IntPtr.Zero && c.Pending.Count == 0)
+					{
+						Fail(c, string.Empty);
+					}
+				}
+			}
+		}
+
+		// the first shared connection without pending commands, otherwise the one with the fewest pending commands
+		private SharedConnection Pick()
+		{
+			SharedConnection best = mConnections[0];
+			int min = Volatile.Read(ref best.PendingCount);
+
+			for (int i = 1; i < mConnections.Length && min > 0; i++)
+			{
+				int n = Volatile.Read(ref mConnections[i].PendingCount);
+
+				if (n < min)
+				{
+					best = mConnections[i];
+					min = n;
+				}
+			}
+
+			return best;
+		}
+
+		// switch conn taken from mPool to pipeline mode, conn is discarded if that fails
+		private IntPtr EnterPipeline(IntPtr conn, ConnStatusType connStatus, PGTransactionStatusType tranStatus)
+		{
+			if (conn == IntPtr.Zero)
+				throw new PqsqlException("libpq: unable to allocate struct PGconn");
+
+			// results are read in blocking mode once the socket is readable
+			if (connStatus == ConnStatusType.CONNECTION_BAD || tranStatus != PGTransactionStatusType.PQTRANS_IDLE ||
+				PqsqlWrapper.PQsetnonblocking(conn, 0) != 0 || PqsqlWrapper.PQenterPipelineMode(conn) == 0)
+			{
+				string err = PqsqlUtils.GetErrorMessage(conn);
+				PqsqlConnectionPool.DiscardPGConn(mPool, conn);
+				throw new PqsqlException("Could not open multiplexed connection: " + err, (int) PqsqlState.CONNECTION_FAILURE);
+			}
+
+			return conn;
+		}
+
+		// wait for the results of the pending commands of c
+		private void Arm(SharedConnection c)
+		{
+			if (c.Reading || c.Pending.Count == 0)
+				return;
+
+			c.Reading = true;
+
+			CancellationTokenSource cts = c.Cancel;
+			PqsqlSocketWaiter.WaitAsync(c.PGConn, PqsqlBinaryFormat.PQSW_READ, cts.Token)
+				.ContinueWith(t => OnReadable(c, cts, t), TaskContinuationOptions.ExecuteSynchronously);
+		}
+
+		private void OnReadable(SharedConnection c, CancellationTokenSource cts, Task wait)
+		{
+			if (wait.IsCanceled)
+				return;
+
+			lock (c)
+			{
+				if (cts != c.Cancel)
+					return; // the connection we waited for is gone
+
+				c.Reading = false;
+
+				if (wait.IsFaulted)
+				{
+					Fail(c, wait.Exception.GetBaseException().Message);
+					return;
+				}
+
+				if (PqsqlWrapper.PQconsumeInput(c.PGConn) == 0 || !Receive(c))
+				{
+					Fail(c, PqsqlUtils.GetErrorMessage(c.PGConn));
+					return;
+				}
+
+				Arm(c);
+			}
+		}
+
+		// hand the completely received results of c to the pending commands,
+		// returns false if the connection is broken
+		private static bool Receive(SharedConnection c)
+		{
+			while (c.Pending.Count > 0 && PqsqlWrapper.PQisBusy(c.PGConn) == 0)
+			{
+				IntPtr res = PqsqlWrapper.PQgetResult(c.PGConn);
+				Request r = c.Pending.Peek();
+
+				if (res == IntPtr.Zero)
+				{
+					// the NULL result ends the results of r, its pipeline sync follows.
+					// two NULL results in a row: there is nothing left to read
+					if (++c.Nulls > 1)
+						return false;
+
+					continue;
+				}
+
+				c.Nulls = 0;
+
+				if (PqsqlWrapper.PQresultStatus(res) == ExecStatusType.PGRES_PIPELINE_SYNC)
+				{
+					PqsqlWrapper.PQclear(res);
+					c.Pending.Dequeue();
+
+					if (r.Result == IntPtr.Zero)
+					{
+						r.Completion.TrySetException(new PqsqlException("Multiplexed statement returned no result"));
+					}
+					else
+					{
+						r.Completion.TrySetResult(r.Result);
+					}
+
+					continue;
+				}
+
+				if (r.Result == IntPtr.Zero)
+				{
+					r.Result = res;
+				}
+				else
+				{
+					PqsqlWrapper.PQclear(res);
+				}
+			}
+
+			Volatile.Write(ref c.PendingCount, c.Pending.Count);
+			return true;
+		}
+
+		// fail the pending commands of c and close its connection, the next command opens a new one
+		private void Fail(SharedConnection c, string err)
+		{
+			c.Cancel.Cancel();
+			c.Cancel = new CancellationTokenSource();
+			c.Reading = false;
+			c.Nulls = 0;
+
+			foreach (Request r in c.Pending)
+			{
+				if (r.Result != IntPtr.Zero)
+				{
+					PqsqlWrapper.PQclear(r.Result);
+				}
+
+				r.Completion.TrySetException(new PqsqlException("Multiplexed connection failed: " + err, (int) PqsqlState.CONNECTION_FAILURE));
+			}
+
+			c.Pending.Clear();
+			Volatile.Write(ref c.PendingCount, 0);
+
+			IntPtr conn = c.PGConn;
+			c.PGConn = IntPtr.Zero;
+			PqsqlConnectionPool.DiscardPGConn(mPool, conn);
+		}
+	}
+}
@@ -113,12 +113,31 @@ namespace Pqsql
 				throw new ArgumentNullException(nameof(parameterCollection));
 #endif
 
+			Reserve(parameterCollection.Count, 0);
+
 			foreach (PqsqlParameter p in parameterCollection)
 			{
 				AddParameter(p);
 			}
 		}
 
+		/// <summary>
+		/// make room for at least n parameters and payloadBytes bytes of parameter values,
+		/// the buffer grows geometrically and keeps its allocations across Clear().
+		/// </summary>
+		public void Reserve(int n, long payloadBytes)
+		{
+			if (n < 0)
+				throw new ArgumentOutOfRangeException(nameof(n));
+			if (payloadBytes < 0)
+				throw new ArgumentOutOfRangeException(nameof(payloadBytes));
+
+			if (mPqPB != IntPtr.Zero && PqsqlBinaryFormat.pqpb_reserve(mPqPB, (UIntPtr) n, (UIntPtr) (ulong) payloadBytes) != 0)
+			{
+				throw new PqsqlException("Cannot reserve space in parameter buffer");
+			}
+		}
+
 		/// <summary>
 		/// append parameter to parameter buffer.
 		/// we convert and infer the right datatype in case the user supplied inconsistent type information.
@@ -302,6 +321,7 @@ namespace Pqsql
 		//
 		// Summary:
 		//     Removes all System.Data.Common.DbParameter values from the System.Data.Common.DbParameterCollection.
+		//     Allocated memory is kept for the next round of parameters.
 		public void Clear()
 		{
 			if (mPqPB != IntPtr.Zero)
@@ -323,12 +343,10 @@ namespace Pqsql
 		// adds o as double array element to PQExpBuffer a
 		internal static void SetNumericArray(IntPtr a, object o)
 		{
-			double d = Convert.ToDouble(o, CultureInfo.InvariantCulture);
-
 			long len0 = PqsqlBinaryFormat.pqbf_get_buflen(a); // get start position
 
 			PqsqlBinaryFormat.pqbf_set_array_itemlength(a, -2); // first set an invalid item length
-			PqsqlBinaryFormat.pqbf_set_numeric(a, d); // encode numeric value (variable length)
+			SetNumeric(a, o); // encode numeric value (variable length)
 
 			int len = (int) (PqsqlBinaryFormat.pqbf_get_buflen(a) - len0); // get new buffer length
 			// update array item length == len - 4 bytes
@@ -450,6 +468,11 @@ namespace Pqsql
 			Action<IntPtr, object> setArrayItem = n.SetArrayItem;
 
 			Array aparam = val as Array;
+
+			// zero-based one-dimensional arrays of fixed-length types are encoded in one go
+			if (AddFixedArray(pb, aparam, oid))
+				return;
+
 			int rank = aparam.Rank;
 
 			// TODO we only support one-dimensional array for now
@@ -511,6 +534,218 @@ namespace Pqsql
 			}
 		}
 
+		// splits nullable array a into values and NULL bitmap nullmap
+		private static T[] GetNullMap<T>(T?[] a, out byte[] nullmap) where T : struct
+		{
+			int n = a.Length;
+			T[] values = new T[n];
+			nullmap = null;
+
+			for (int i = 0; i < n; i++)
+			{
+				if (a[i].HasValue)
+				{
+					values[i] = a[i].Value;
+				}
+				else
+				{
+					if (nullmap == null)
+						nullmap = new byte[(n + 7) / 8];
+					nullmap[i >> 3] |= (byte) (1 << (i & 7));
+				}
+			}
+
+			return values;
+		}
+
+		// adds T[] and T?[] arrays with T in { short, int, long, float, double, uint } as array parameter
+		// without per-item encoding, returns false iff aparam is not such an array matching oid
+		private static unsafe bool AddFixedArray(IntPtr pb, Array aparam, PqsqlDbType oid)
+		{
+			Type t = aparam.GetType();
+			byte[] nullmap = null;
+
+			switch (oid)
+			{
+			case PqsqlDbType.Int2:
+				short[] i2;
+				if (t == typeof(short[]))
+					i2 = (short[]) aparam;
+				else if (t == typeof(short?[]))
+					i2 = GetNullMap((short?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (short* v = i2)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_int2_array(pb, v, i2.Length, nm);
+				}
+				return true;
+
+			case PqsqlDbType.Int4:
+				int[] i4;
+				if (t == typeof(int[]))
+					i4 = (int[]) aparam;
+				else if (t == typeof(int?[]))
+					i4 = GetNullMap((int?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (int* v = i4)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_int4_array(pb, v, i4.Length, nm);
+				}
+				return true;
+
+			case PqsqlDbType.Int8:
+				long[] i8;
+				if (t == typeof(long[]))
+					i8 = (long[]) aparam;
+				else if (t == typeof(long?[]))
+					i8 = GetNullMap((long?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (long* v = i8)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_int8_array(pb, v, i8.Length, nm);
+				}
+				return true;
+
+			case PqsqlDbType.Float4:
+				float[] f4;
+				if (t == typeof(float[]))
+					f4 = (float[]) aparam;
+				else if (t == typeof(float?[]))
+					f4 = GetNullMap((float?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (float* v = f4)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_float4_array(pb, v, f4.Length, nm);
+				}
+				return true;
+
+			case PqsqlDbType.Float8:
+				double[] f8;
+				if (t == typeof(double[]))
+					f8 = (double[]) aparam;
+				else if (t == typeof(double?[]))
+					f8 = GetNullMap((double?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (double* v = f8)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_float8_array(pb, v, f8.Length, nm);
+				}
+				return true;
+
+			case PqsqlDbType.Oid:
+				uint[] o;
+				if (t == typeof(uint[]))
+					o = (uint[]) aparam;
+				else if (t == typeof(uint?[]))
+					o = GetNullMap((uint?[]) aparam, out nullmap);
+				else
+					return false;
+
+				fixed (uint* v = o)
+				fixed (byte* nm = nullmap)
+				{
+					PqsqlBinaryFormat.pqbf_add_oid_array(pb, v, o.Length, nm);
+				}
+				return true;
+			}
+
+			return false;
+		}
+
+		#endregion
+
+
+		#region numeric encoding
+
+		// returns false iff o is a floating point value or string which cannot be represented as decimal
+		// (NaN, Infinity, out of range), these values are encoded through Convert.ToDouble as before
+		private static bool TryGetDecimal(object o, out decimal dec)
+		{
+			string s = o as string;
+
+			if (s != null)
+				return decimal.TryParse(s, NumberStyles.Float, CultureInfo.InvariantCulture, out dec);
+
+			if (o is double || o is float)
+			{
+				double d = Convert.ToDouble(o, CultureInfo.InvariantCulture);
+
+				if (double.IsNaN(d) || d <= (double) decimal.MinValue || d >= (double) decimal.MaxValue)
+				{
+					dec = 0;
+					return false;
+				}
+			}
+
+			dec = Convert.ToDecimal(o, CultureInfo.InvariantCulture);
+			return true;
+		}
+
+		// adds o as numeric parameter to pqparam_buffer pb
+		internal static void AddNumeric(IntPtr pb, object o)
+		{
+			decimal dec;
+
+			if (!TryGetDecimal(o, out dec))
+			{
+				// NaN and +-Infinity
+				PqsqlBinaryFormat.pqbf_add_numeric(pb, Convert.ToDouble(o, CultureInfo.InvariantCulture));
+				return;
+			}
+
+			uint lo;
+			uint mid;
+			uint hi;
+			int scale;
+			int sign;
+
+			PqsqlBinaryFormat.GetDecimal(dec, out lo, out mid, out hi, out scale, out sign);
+			PqsqlBinaryFormat.pqbf_add_decimal(pb, lo, mid, hi, scale, sign);
+		}
+
+		// encodes o as numeric to PQExpBuffer a
+		internal static void SetNumeric(IntPtr a, object o)
+		{
+			decimal dec;
+
+			if (!TryGetDecimal(o, out dec))
+			{
+				// NaN and +-Infinity
+				PqsqlBinaryFormat.pqbf_set_numeric(a, Convert.ToDouble(o, CultureInfo.InvariantCulture));
+				return;
+			}
+
+			SetNumeric(a, dec);
+		}
+
+		// encodes dec as numeric to PQExpBuffer a
+		internal static void SetNumeric(IntPtr a, decimal dec)
+		{
+			uint lo;
+			uint mid;
+			uint hi;
+			int scale;
+			int sign;
+
+			PqsqlBinaryFormat.GetDecimal(dec, out lo, out mid, out hi, out scale, out sign);
+			PqsqlBinaryFormat.pqbf_set_decimal(a, lo, mid, hi, scale, sign);
+		}
+
 		#endregion
 
 
@@ -0,0 +1,379 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.Runtime.InteropServices;
+#if CODECONTRACTS
+using System.Diagnostics.Contracts;
+#endif
+
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+
+namespace Pqsql
+{
+	/// <summary>
+	/// maps statement text and parameter type oids to server-side prepared statements of a
+	/// single PGconn. Prepared statements only live as long as the session of the PGconn,
+	/// so the cache must be cleared whenever the session is reset (DISCARD ALL, PQreset, ...)
+	/// </summary>
+	internal sealed class PqsqlPreparedStatementCache
+	{
+		/// <summary>
+		/// how TryGetStatement prepares a statement which is not prepared yet
+		/// </summary>
+		public enum PrepareMode
+		{
+			// only after AutoPrepareMinUsages executions, evicted least recently used first
+			Auto,
+			// PqsqlCommand.Prepare(), never evicted
+			Explicit,
+			// PqsqlBatch, prepared immediately and evicted least recently used first
+			Batch
+		}
+
+		/// <summary>
+		/// statement text and parameter type oids of a prepared statement
+		/// </summary>
+		private sealed class StatementKey : IEquatable<StatementKey>
+		{
+			private readonly string mStatement;
+			private readonly uint[] mTypes;
+			private readonly int mHash;
+
+			public StatementKey(string statement, uint[] types)
+			{
+				mStatement = statement;
+				mTypes = types;
+
+				int h = statement.GetHashCode();
+				foreach (uint t in types)
+				{
+					h = h * 31 + (int) t;
+				}
+				mHash = h;
+			}
+
+			public bool Equals(StatementKey other)
+			{
+				if (other == null || mHash != other.mHash || mTypes.Length != other.mTypes.Length)
+					return false;
+
+				for (int i = 0; i < mTypes.Length; i++)
+				{
+					if (mTypes[i] != other.mTypes[i])
+						return false;
+				}
+
+				return string.Equals(mStatement, other.mStatement, StringComparison.Ordinal);
+			}
+
+			public override bool Equals(object obj)
+			{
+				return Equals(obj as StatementKey);
+			}
+
+			public override int GetHashCode()
+			{
+				return mHash;
+			}
+		}
+
+		/// <summary>
+		/// a prepared statement of the current session
+		/// </summary>
+		private sealed class Entry
+		{
+			public StatementKey Key;
+			// statement name
+			public string Name;
+			// null-terminated UTF-8 statement name
+			public byte[] Utf8Name;
+			// position in the LRU list of automatically prepared statements, null for explicitly prepared statements
+			public LinkedListNode<Entry> LruNode;
+		}
+
+		// prefix of the server-side statement names
+		private const string StatementNamePrefix = "pqsql_";
+
+		// upper bound of tracked usage counters of statements not (yet) prepared automatically
+		private const int MaxTrackedStatements = 1024;
+
+		// prepared statements of the current session
+		private readonly Dictionary<StatementKey, Entry> mStatements = new Dictionary<StatementKey, Entry>();
+
+		// automatically prepared statements, most recently used first
+		private readonly LinkedList<Entry> mLru = new LinkedList<Entry>();
+
+		// number of executions of statements which are candidates for automatic preparation
+		private readonly Dictionary<StatementKey, int> mUsages = new Dictionary<StatementKey, int>();
+
+		// max number of automatically prepared statements, 0 disables automatic preparation
+		private readonly int mMaxAutoPrepare;
+
+		// number of executions after which a statement will be prepared automatically
+		private readonly int mAutoPrepareMinUsages;
+
+		// number of statements prepared so far, used to create unique statement names
+		private int mPrepared;
+
+		// number of automatically prepared statements evicted so far
+		private int mEvictions;
+
+		public PqsqlPreparedStatementCache(int maxAutoPrepare, int autoPrepareMinUsages)
+		{
+			mMaxAutoPrepare = Math.Max(0, maxAutoPrepare);
+			mAutoPrepareMinUsages = Math.Max(1, autoPrepareMinUsages);
+		}
+
+		// true if frequently executed statements will be prepared automatically
+		public bool AutoPrepare
+		{
+			get { return mMaxAutoPrepare > 0; }
+		}
+
+		// number of automatically prepared statements evicted so far
+		public int Evictions
+		{
+			get { return mEvictions; }
+		}
+
+		// number of prepared statements in the current session
+		public int Count
+		{
+			get { return mStatements.Count; }
+		}
+
+		// Summary:
+		//     Forgets all prepared statements. Must be called whenever the server-side
+		//     session of the connection has been reset.
+		public void Clear()
+		{
+			// keep mPrepared: statement names are never reused, so a statement of the
+			// session we did not know about cannot clash with a new one
+			mStatements.Clear();
+			mLru.Clear();
+			mUsages.Clear();
+		}
+
+		// Summary:
+		//     Looks up the prepared statement for stmt and the num_param parameter type oids
+		//     in ptyps. With PrepareMode.Explicit and PrepareMode.Batch, or if stmt has been
+		//     executed often enough with automatic preparation enabled, stmt will be prepared
+		//     with PQsendPrepare on conn. Automatically prepared and batch statements are
+		//     evicted least recently used first with DEALLOCATE once more than MaxAutoPrepare
+		//     (at least one) statements are prepared.
+		//
+		// Returns:
+		//     false if stmt could not be prepared explicitly or for a batch, or a failed
+		//     automatic preparation left conn unusable, otherwise true. name is set to the
+		//     null-terminated UTF-8 statement name, or null if stmt is not prepared and
+		//     must be executed unprepared.
+		public bool TryGetStatement(IntPtr conn, string stmt, byte[] utf8query, int num_param, IntPtr ptyps, PrepareMode mode, out byte[] name)
+		{
+#if CODECONTRACTS
+			Contract.Requires<ArgumentNullException>(stmt != null);
+			Contract.Requires<ArgumentNullException>(utf8query != null);
+#endif
+
+			uint[] types = new uint[num_param];
+			for (int i = 0; i < num_param; i++)
+			{
+				types[i] = (uint) Marshal.ReadInt32(ptyps, i * sizeof(uint));
+			}
+
+			StatementKey key = new StatementKey(stmt, types);
+			Entry entry;
+
+			if (mStatements.TryGetValue(key, out entry))
+			{
+				LinkedListNode<Entry> node = entry.LruNode;
+
+				if (node != null)
+				{
+					mLru.Remove(node);
+
+					if (mode == PrepareMode.Explicit)
+					{
+						entry.LruNode = null; // explicitly prepared statements are never evicted
+					}
+					else
+					{
+						mLru.AddFirst(node);
+					}
+				}
+
+				name = entry.Utf8Name;
+				return true;
+			}
+
+			name = null;
+
+			if (mode == PrepareMode.Auto)
+			{
+				if (mMaxAutoPrepare == 0)
+					return true;
+
+				int usages;
+				mUsages.TryGetValue(key, out usages);
+				usages++;
+
+				if (usages < mAutoPrepareMinUsages)
+				{
+					if (usages == 1 && mUsages.Count >= MaxTrackedStatements)
+					{
+						mUsages.Clear(); // start counting from scratch
+					}
+
+					mUsages[key] = usages;
+					return true;
+				}
+
+				mUsages.Remove(key);
+
+				// make room for stmt, just execute it unprepared if we cannot evict
+				if (mLru.Count >= mMaxAutoPrepare && !Evict(conn, mLru.Last.Value))
+					return true;
+			}
+			else if (mode == PrepareMode.Batch)
+			{
+				// without automatic preparation we keep the statement of the last batch only
+				if (mLru.Count >= Math.Max(mMaxAutoPrepare, 1) && !Evict(conn, mLru.Last.Value))
+					return false;
+			}
+
+			string newName = StatementNamePrefix + mPrepared.ToString(CultureInfo.InvariantCulture);
+			byte[] utf8Name = PqsqlUTF8Statement.CreateUTF8Statement(newName);
+
+			if (!Prepare(conn, utf8Name, utf8query, num_param, ptyps))
+			{
+				// execute stmt unprepared, unless the failed Parse aborted the transaction
+				// or broke the connection: then the unprepared execution could only hide the error
+				return mode == PrepareMode.Auto &&
+					PqsqlWrapper.PQstatus(conn) == ConnStatusType.CONNECTION_OK &&
+					PqsqlWrapper.PQtransactionStatus(conn) != PGTransactionStatusType.PQTRANS_INERROR;
+			}
+
+			mPrepared++;
+
+			entry = new Entry { Key = key, Name = newName, Utf8Name = utf8Name };
+			if (mode != PrepareMode.Explicit)
+			{
+				entry.LruNode = mLru.AddFirst(entry);
+			}
+			mStatements.Add(key, entry);
+
+			name = utf8Name;
+			return true;
+		}
+
+		// Summary:
+		//     Forgets the prepared statements dropped by stmt, see
+		//     PqsqlCommand.DropsPreparedStatements: only the named statement for
+		//     DEALLOCATE name, all statements for DEALLOCATE ALL and DISCARD ALL.
+		public void Drop(string stmt)
+		{
+			string[] words = stmt.Trim().TrimEnd(';').Split((char[]) null, StringSplitOptions.RemoveEmptyEntries);
+
+			if (words.Length < 2)
+				return;
+
+			string arg = words[words.Length - 1];
+
+			if (words[0].Equals("discard", StringComparison.OrdinalIgnoreCase))
+			{
+				// DISCARD PLANS, SEQUENCES, and TEMP keep the prepared statements
+				if (arg.Equals("all", StringComparison.OrdinalIgnoreCase))
+				{
+					Clear();
+				}
+				return;
+			}
+
+			// DEALLOCATE [ PREPARE ] { name | ALL }
+			if (arg.Equals("all", StringComparison.OrdinalIgnoreCase))
+			{
+				Clear();
+				return;
+			}
+
+			// unquoted identifiers are folded to lower case, our statement names are lower case anyway
+			string name = arg.Length > 1 && arg[0] == '"' ? arg.Trim('"') : arg.ToLowerInvariant();
+
+			foreach (Entry entry in mStatements.Values)
+			{
+				if (string.Equals(entry.Name, name, StringComparison.Ordinal))
+				{
+					Remove(entry);
+					return;
+				}
+			}
+		}
+
+		// remove entry from the cache
+		private void Remove(Entry entry)
+		{
+			mStatements.Remove(entry.Key);
+
+			if (entry.LruNode != null)
+			{
+				mLru.Remove(entry.LruNode);
+				entry.LruNode = null;
+			}
+		}
+
+		// DEALLOCATE the server-side statement of entry and remove entry from the cache;
+		// if DEALLOCATE fails, the statement might still exist and entry is kept
+		private bool Evict(IntPtr conn, Entry entry)
+		{
+			// statement names are plain identifiers, no quoting necessary
+			byte[] deallocate = PqsqlUTF8Statement.CreateUTF8Statement("DEALLOCATE " + entry.Name);
+
+			ExecStatusType s = ExecStatusType.PGRES_FATAL_ERROR;
+
+			unsafe
+			{
+				fixed (byte* st = deallocate)
+				{
+					IntPtr res = PqsqlWrapper.PQexec(conn, st);
+
+					if (res != IntPtr.Zero)
+					{
+						s = PqsqlWrapper.PQresultStatus(res);
+						PqsqlWrapper.PQclear(res);
+					}
+				}
+			}
+
+			if (s != ExecStatusType.PGRES_COMMAND_OK)
+				return false;
+
+			Remove(entry);
+			mEvictions++;
+			return true;
+		}
+
+		// send Parse message for statement name and wait for its result
+		private static bool Prepare(IntPtr conn, byte[] name, byte[] utf8query, int num_param, IntPtr ptyps)
+		{
+			unsafe
+			{
+				fixed (byte* pn = name)
+				fixed (byte* pq = utf8query)
+				{
+					if (PqsqlWrapper.PQsendPrepare(conn, pn, pq, num_param, ptyps) == 0)
+						return false;
+				}
+			}
+
+			// consume and clear results until we reach the NULL result, PQerrorMessage keeps the error of a failed Parse
+			ExecStatusType s = ExecStatusType.PGRES_FATAL_ERROR;
+			IntPtr res;
+			while ((res = PqsqlWrapper.PQgetResult(conn)) != IntPtr.Zero)
+			{
+				s = PqsqlWrapper.PQresultStatus(res);
+				PqsqlWrapper.PQclear(res);
+			}
+
+			return s == ExecStatusType.PGRES_COMMAND_OK;
+		}
+	}
+}
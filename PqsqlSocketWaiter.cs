@@ -0,0 +1,235 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
+using PqsqlBinaryFormat = Pqsql.UnsafeNativeMethods.PqsqlBinaryFormat;
+
+namespace Pqsql
+{
+	/// <summary>
+	/// asynchronous waits for socket readiness of PGconn. With epoll (Linux), all waits are
+	/// registered in a single pqwait_set and completed by one background thread, so no thread
+	/// is blocked per waiting connection. Otherwise, each wait polls on a thread pool thread.
+	/// </summary>
+	internal static class PqsqlSocketWaiter
+	{
+		// max number of ready registrations received with one pqsw_wait_any() call
+		private const int MaxEvents = 64;
+
+		// poll timeout in ms of the fallback without pqwait_set, cancellation is checked in between
+		private const int FallbackPollTimeout = 100;
+
+		private static readonly object mLock = new object();
+
+		// pending waits by registration token
+		private static readonly Dictionary<long, TaskCompletionSource<bool>> mWaiters = new Dictionary<long, TaskCompletionSource<bool>>();
+
+		// pqwait_set of all pending waits, IntPtr.Zero if not available
+		private static IntPtr mWaitSet;
+
+		private static bool mInitialized;
+
+		private static long mNextToken;
+
+		// create mWaitSet and start the thread completing the pending waits
+		private static void Init()
+		{
+			mInitialized = true;
+			mWaitSet = PqsqlBinaryFormat.pqsw_create();
+
+			if (mWaitSet == IntPtr.Zero)
+				return;
+
+			Thread poller = new Thread(Poll)
+			{
+				IsBackground = true,
+				Name = "Pqsql socket waiter"
+			};
+			poller.Start();
+		}
+
+		private static void Poll()
+		{
+			long[] tokens = new long[MaxEvents];
+
+			while (true)
+			{
+				int n;
+
+				unsafe
+				{
+					fixed (long* t = tokens)
+					{
+						n = PqsqlBinaryFormat.pqsw_wait_any(mWaitSet, t, MaxEvents, -1);
+					}
+				}
+
+				List<TaskCompletionSource<bool>> failed = null;
+
+				lock (mLock)
+				{
+					if (n < 0)
+					{
+						// epoll is broken, fail the pending waits and let further waits use the fallback
+						failed = new List<TaskCompletionSource<bool>>(mWaiters.Values);
+						mWaiters.Clear();
+						mWaitSet = IntPtr.Zero;
+					}
+				}
+
+				if (failed != null)
+				{
+					foreach (TaskCompletionSource<bool> f in failed)
+					{
+						f.TrySetException(new PqsqlException("Could not wait for socket readiness"));
+					}
+					return;
+				}
+
+				for (int i = 0; i < n; i++)
+				{
+					TaskCompletionSource<bool> tcs;
+
+					lock (mLock)
+					{
+						if (mWaiters.TryGetValue(tokens[i], out tcs))
+						{
+							mWaiters.Remove(tokens[i]);
+						}
+					}
+
+					// continuations run asynchronously, not on the poller thread
+					tcs?.TrySetResult(true);
+				}
+			}
+		}
+
+		// Summary:
+		//     Waits until the socket of conn is ready for events (PQSW_READ and/or PQSW_WRITE).
+		//     Errors and hangups of the socket are reported as ready, the next libpq call on
+		//     conn will notice them.
+		public static async Task WaitAsync(IntPtr conn, int events, CancellationToken cancellationToken)
+		{
+			cancellationToken.ThrowIfCancellationRequested();
+
+			TaskCompletionSource<bool> tcs = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+			long token;
+			IntPtr ws;
+
+			lock (mLock)
+			{
+				if (!mInitialized)
+				{
+					Init();
+				}
+
+				ws = mWaitSet;
+				token = ++mNextToken;
+
+				if (ws != IntPtr.Zero)
+				{
+					mWaiters.Add(token, tcs);
+				}
+			}
+
+			if (ws == IntPtr.Zero)
+			{
+				await Task.Run(() => Wait(conn, events, cancellationToken), cancellationToken).ConfigureAwait(false);
+				return;
+			}
+
+			if (PqsqlBinaryFormat.pqsw_add(ws, conn, events, token) != 0)
+			{
+				lock (mLock)
+				{
+					mWaiters.Remove(token);
+				}
+				throw new PqsqlException("Could not wait for socket readiness");
+			}
+
+			using (cancellationToken.Register(() => Cancel(token, cancellationToken)))
+			{
+				await tcs.Task.ConfigureAwait(false);
+			}
+		}
+
+		// drop the pending wait of token, its one-shot registration is ignored when it fires
+		private static void Cancel(long token, CancellationToken cancellationToken)
+		{
+			TaskCompletionSource<bool> tcs;
+
+			lock (mLock)
+			{
+				if (!mWaiters.TryGetValue(token, out tcs))
+					return;
+
+				mWaiters.Remove(token);
+			}
+
+			tcs.TrySetCanceled(cancellationToken);
+		}
+
+		// fallback without pqwait_set: poll on the current thread
+		private static void Wait(IntPtr conn, int events, CancellationToken cancellationToken)
+		{
+			int ready;
+
+			while ((ready = PqsqlBinaryFormat.pqsw_wait(conn, events, FallbackPollTimeout)) == 0)
+			{
+				cancellationToken.ThrowIfCancellationRequested();
+			}
+
+			if (ready < 0)
+			{
+				throw new PqsqlException("Could not wait for socket readiness");
+			}
+		}
+
+		// Summary:
+		//     Sends the queued output of conn in non-blocking mode, see PQsetnonblocking().
+		public static async Task FlushAsync(IntPtr conn, CancellationToken cancellationToken)
+		{
+			int f;
+
+			while ((f = PqsqlWrapper.PQflush(conn)) > 0)
+			{
+				// the server may wait for us to read its output before it accepts more input
+				await WaitAsync(conn, PqsqlBinaryFormat.PQSW_READ | PqsqlBinaryFormat.PQSW_WRITE, cancellationToken).ConfigureAwait(false);
+
+				if (PqsqlWrapper.PQconsumeInput(conn) == 0)
+				{
+					f = -1;
+					break;
+				}
+			}
+
+			if (f < 0)
+			{
+				throw new PqsqlException("Could not send query: " + PqsqlUtils.GetErrorMessage(conn));
+			}
+		}
+
+		// Summary:
+		//     Waits until the next PQgetResult() on conn does not block. Errors of the
+		//     connection are left to PQgetResult().
+		public static async Task ConsumeInputAsync(IntPtr conn, CancellationToken cancellationToken)
+		{
+			while (IsBusy(conn))
+			{
+				await WaitAsync(conn, PqsqlBinaryFormat.PQSW_READ, cancellationToken).ConfigureAwait(false);
+			}
+		}
+
+		// Summary:
+		//     Reads available input of conn and returns true if PQgetResult() would block.
+		public static bool IsBusy(IntPtr conn)
+		{
+			if (PqsqlWrapper.PQconsumeInput(conn) == 0)
+				return false; // PQgetResult() reports the error
+
+			return PqsqlWrapper.PQisBusy(conn) == 1;
+		}
+	}
+}
@@ -0,0 +1,164 @@
+﻿using System;
+using System.Data;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Pqsql;
+
+namespace PqsqlTests
+{
+	[TestClass]
+	public class PqsqlBatchTests
+	{
+		private static string connectionString = string.Empty;
+
+		private PqsqlConnection mConnection;
+
+		#region Additional test attributes
+
+		[ClassInitialize]
+		public static void ClassInitialize(TestContext context)
+		{
+			connectionString = context.Properties["connectionString"].ToString();
+		}
+
+		[TestInitialize]
+		public void TestInitialize()
+		{
+			mConnection = new PqsqlConnection(connectionString);
+		}
+
+		[TestCleanup]
+		public void TestCleanup()
+		{
+			mConnection.Dispose();
+		}
+
+		#endregion
+
+		[TestMethod]
+		public void PqsqlBatchTest1()
+		{
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+
+			PqsqlCommand cmd = new PqsqlCommand("create temporary table batch (i int4, t text)", mConnection) { Transaction = tran };
+			cmd.ExecuteNonQuery();
+
+			cmd.CommandText = "insert into batch values (:i, :t)";
+			cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32));
+			cmd.Parameters.Add(new PqsqlParameter("t", DbType.String));
+
+			PqsqlBatch batch = new PqsqlBatch(cmd);
+
+			const int n = 2500;
+			for (int i = 0; i < n; i++)
+			{
+				batch.Add(i, i % 3 == 0 ? (object) DBNull.Value : "row " + i);
+			}
+
+			Assert.AreEqual(n, batch.Count);
+
+			int[] affected = batch.ExecuteNonQuery();
+
+			Assert.AreEqual(n, affected.Length);
+			foreach (int a in affected)
+			{
+				Assert.AreEqual(1, a);
+			}
+
+			// parameter values are restored
+			Assert.IsNull(cmd.Parameters["i"].Value);
+
+			cmd.Parameters.Clear();
+			cmd.CommandText = "select count(*), count(t), sum(i) from batch";
+
+			using (PqsqlDataReader r = cmd.ExecuteReader())
+			{
+				Assert.IsTrue(r.Read());
+				Assert.AreEqual((long) n, r.GetInt64(0));
+				Assert.AreEqual((long) (n - (n + 2) / 3), r.GetInt64(1));
+				Assert.AreEqual((long) n * (n - 1) / 2, r.GetInt64(2));
+			}
+
+			// update with per-row affected counts
+			cmd.CommandText = "update batch set t = 'x' where i < :i";
+			cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32));
+
+			batch = new PqsqlBatch(cmd);
+			batch.Add(0);
+			batch.Add(10);
+			batch.Add(100);
+
+			affected = batch.ExecuteNonQuery();
+			CollectionAssert.AreEqual(new[] { 0, 10, 100 }, affected);
+
+			tran.Rollback();
+		}
+
+		[TestMethod]
+		public void PqsqlBatchTest2()
+		{
+			PqsqlCommand cmd = new PqsqlCommand("select 1 / :i", mConnection);
+			cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32));
+
+			PqsqlBatch batch = new PqsqlBatch(cmd);
+			batch.Add(1);
+			batch.Add(0);
+			batch.Add(2);
+
+			try
+			{
+				batch.ExecuteNonQuery();
+				Assert.Fail("division by zero should have been raised");
+			}
+			catch (PqsqlException e)
+			{
+				Assert.AreEqual("22012", e.SqlState);
+			}
+
+			// connection is still usable
+			cmd.Parameters.Clear();
+			cmd.CommandText = "select 42";
+			Assert.AreEqual(42, cmd.ExecuteScalar());
+		}
+
+		[TestMethod]
+		public void PqsqlBatchTest3()
+		{
+			// the results of all rows do not fit into the socket buffers
+			PqsqlCommand cmd = new PqsqlCommand("select repeat('x', 10000) from generate_series(1, :i)", mConnection);
+			cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32));
+
+			PqsqlBatch batch = new PqsqlBatch(cmd);
+			for (int i = 0; i < 2000; i++)
+			{
+				batch.Add(2);
+			}
+
+			int[] affected = batch.ExecuteNonQuery();
+			Assert.AreEqual(2000, affected.Length);
+			Assert.IsTrue(Array.TrueForAll(affected, n => n == 2));
+		}
+
+		[TestMethod]
+		public void PqsqlBatchTest4()
+		{
+			// own application_name: a fresh pooled connection without prepared statements
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";application_name=pqsql_batchtest4"))
+			{
+				foreach (string stmt in new[] { "select :i + 1", "select :i + 2", "select :i + 3" })
+				{
+					PqsqlCommand cmd = new PqsqlCommand(stmt, conn);
+					cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32));
+
+					PqsqlBatch batch = new PqsqlBatch(cmd);
+					batch.Add(1);
+					batch.Add(2);
+					batch.ExecuteNonQuery();
+				}
+
+				// without automatic preparation only the statement of the last batch is kept
+				PqsqlCommand count = new PqsqlCommand("select count(*) from pg_prepared_statements where name like 'pqsql\\_%'", conn);
+				Assert.AreEqual(1L, count.ExecuteScalar());
+			}
+		}
+	}
+}
@@ -574,5 +574,200 @@ namespace PqsqlTests
 				}
 			}
 		}
+
+		[TestMethod]
+		public void PqsqlCommandTest20()
+		{
+			using (PqsqlCommand cmd = new PqsqlCommand("select :p1 + 1; select :p1 * 2", mConnection))
+			{
+				PqsqlParameter p1 = cmd.Parameters.AddWithValue("p1", 0);
+				p1.DbType = DbType.Int32;
+
+				cmd.Prepare();
+				Assert.IsTrue(cmd.IsPrepared);
+
+				for (int i = 0; i < 10; i++)
+				{
+					p1.Value = i;
+
+					PqsqlDataReader r = cmd.ExecuteReader();
+
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(i + 1, r.GetInt32(0));
+					Assert.IsTrue(r.NextResult());
+					Assert.AreEqual(i * 2, r.GetInt32(0));
+
+					r.Close();
+				}
+			}
+
+			using (PqsqlCommand cmd = new PqsqlCommand("select count(*) from pg_prepared_statements where name like 'pqsql\\_%'", mConnection))
+			{
+				Assert.AreEqual(2L, cmd.ExecuteScalar());
+			}
+
+			using (PqsqlCommand cmd = new PqsqlCommand("discard all", mConnection))
+			{
+				cmd.ExecuteNonQuery();
+			}
+
+			// statements must be prepared again after DISCARD ALL
+			using (PqsqlCommand cmd = new PqsqlCommand("select :p1 + 1", mConnection))
+			{
+				cmd.Parameters.AddWithValue("p1", 41).DbType = DbType.Int32;
+				cmd.Prepare();
+				Assert.AreEqual(42, cmd.ExecuteScalar());
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlCommandTest21()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";max_auto_prepare=2;auto_prepare_min_usages=2"))
+			{
+				string[] statements = { "select 1", "select 2", "select 3" };
+
+				for (int i = 0; i < 3; i++)
+				{
+					for (int j = 0; j < statements.Length; j++)
+					{
+						using (PqsqlCommand cmd = new PqsqlCommand(statements[j], conn))
+						{
+							Assert.AreEqual(j + 1, cmd.ExecuteScalar());
+						}
+					}
+				}
+
+				// select 1 and select 2 got prepared in the second round, select 3 evicted select 1
+				using (PqsqlCommand cmd = new PqsqlCommand("select count(*) from pg_prepared_statements where name like 'pqsql\\_%'", conn))
+				{
+					Assert.AreEqual(2L, cmd.ExecuteScalar());
+				}
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlCommandTest22()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";pipeline_mode=true"))
+			using (PqsqlCommand cmd = new PqsqlCommand("create temporary table pipe (i int4); insert into pipe select generate_series(1, :n); select i from pipe order by i; select count(*) from pipe", conn))
+			{
+				cmd.Parameters.AddWithValue("n", 100).DbType = DbType.Int32;
+
+				using (PqsqlDataReader r = cmd.ExecuteReader())
+				{
+					// create and insert do not return rows
+					Assert.IsTrue(r.NextResult());
+					Assert.AreEqual(100, r.RecordsAffected);
+					Assert.IsTrue(r.NextResult());
+
+					int n = 0;
+					while (r.Read())
+					{
+						Assert.AreEqual(++n, r.GetInt32(0));
+					}
+					Assert.AreEqual(100, n);
+
+					Assert.IsTrue(r.NextResult());
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(100L, r.GetInt64(0));
+					Assert.IsFalse(r.NextResult());
+				}
+
+				// an error aborts the remaining statements, the connection stays usable
+				cmd.CommandText = "select 1; select 1/0; select 3";
+				cmd.Parameters.Clear();
+
+				using (PqsqlDataReader r = cmd.ExecuteReader())
+				{
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(1, r.GetInt32(0));
+
+					try
+					{
+						r.NextResult();
+						Assert.Fail("division by zero should have been raised");
+					}
+					catch (PqsqlException)
+					{
+						// expected
+					}
+
+					Assert.IsFalse(r.NextResult());
+				}
+
+				cmd.CommandText = "select 42";
+				Assert.AreEqual(42, cmd.ExecuteScalar());
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlCommandTest23()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString))
+			using (PqsqlCommand cmd = new PqsqlCommand("create temporary table direct (i int4, t text)", conn))
+			{
+				Assert.AreEqual(0, cmd.ExecuteNonQuery());
+
+				cmd.CommandText = "insert into direct select i, 'x' || i from generate_series(1, :n) i; update direct set t = null where i > 5";
+				cmd.Parameters.AddWithValue("n", 10).DbType = DbType.Int32;
+				Assert.AreEqual(15, cmd.ExecuteNonQuery());
+				cmd.Parameters.Clear();
+
+				cmd.CommandText = "select i from direct";
+				Assert.AreEqual(-1, cmd.ExecuteNonQuery());
+
+				cmd.CommandText = "select t from direct where i = 3";
+				Assert.AreEqual("x3", cmd.ExecuteScalar());
+
+				cmd.CommandText = "select t from direct where i = 7";
+				Assert.AreEqual(DBNull.Value, cmd.ExecuteScalar());
+
+				cmd.CommandText = "select t from direct where i = 11";
+				Assert.IsNull(cmd.ExecuteScalar());
+
+				cmd.CommandText = "delete from direct";
+				Assert.IsNull(cmd.ExecuteScalar());
+
+				// errors are raised with the SQLSTATE of the result, the connection stays usable
+				cmd.CommandText = "select 1/0";
+				try
+				{
+					cmd.ExecuteScalar();
+					Assert.Fail();
+				}
+				catch (PqsqlException e)
+				{
+					Assert.AreEqual((int) PqsqlState.DIVISION_BY_ZERO, e.ErrorCode);
+				}
+
+				cmd.CommandText = "select 42";
+				Assert.AreEqual(42, cmd.ExecuteScalar());
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlCommandTest24()
+		{
+			// own application_name: a fresh pooled connection without prepared statements
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";max_auto_prepare=2;auto_prepare_min_usages=2;application_name=pqsql_test24"))
+			{
+				string[] statements = { "select 1", "select 2", "select 1", "select 2", "deallocate pqsql_0", "select 2", "select 2", "select 1" };
+
+				foreach (string stmt in statements)
+				{
+					using (PqsqlCommand cmd = new PqsqlCommand(stmt, conn))
+					{
+						cmd.ExecuteNonQuery();
+					}
+				}
+
+				// deallocate only dropped select 1, select 2 kept its prepared statement
+				using (PqsqlCommand cmd = new PqsqlCommand("select string_agg(name, ',' order by name) from pg_prepared_statements where name like 'pqsql\\_%'", conn))
+				{
+					Assert.AreEqual("pqsql_1", cmd.ExecuteScalar());
+				}
+			}
+		}
 	}
 }
@@ -1,4 +1,5 @@
 ﻿using System;
+using System.Data;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
 
@@ -111,5 +112,28 @@ namespace PqsqlTests
 				connection.Close();
 			}
 		}
+
+		[TestMethod]
+		public void PqsqlConnectionStringBuilderTest4()
+		{
+			PqsqlConnectionStringBuilder builder = new PqsqlConnectionStringBuilder(connectionString + ";Max Auto Prepare=3;Auto Prepare Min Usages=2");
+
+			Assert.AreEqual(3, builder.MaxAutoPrepare);
+			Assert.AreEqual(2, builder.AutoPrepareMinUsages);
+			Assert.IsTrue(builder.ContainsKey(PqsqlConnectionStringBuilder.max_auto_prepare));
+			Assert.IsTrue(builder.ContainsKey(PqsqlConnectionStringBuilder.auto_prepare_min_usages));
+
+			// Pqsql-specific settings must not be passed to libpq
+			using (PqsqlConnection connection = new PqsqlConnection(builder))
+			{
+				connection.Open();
+				Assert.AreEqual(ConnectionState.Open, connection.State);
+			}
+
+			builder = new PqsqlConnectionStringBuilder(connectionString);
+			Assert.AreEqual(0, builder.MaxAutoPrepare);
+			Assert.AreEqual(5, builder.AutoPrepareMinUsages);
+			Assert.AreEqual(0, builder.MaxPoolSize); // no limit unless max_pool_size is set
+		}
 	}
 }
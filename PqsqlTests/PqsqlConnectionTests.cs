@@ -1,6 +1,8 @@
 ﻿using System;
 using System.Data;
 using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
 
@@ -366,5 +368,343 @@ namespace PqsqlTests
 			Assert.AreEqual((int)PgEnc.PG_UTF8, client_encoding, "wrong client_encoding");
 		}
 
+		[TestMethod]
+		public async Task PqsqlConnectionTest11()
+		{
+			PqsqlConnectionPool.Clear();
+
+			using (PqsqlConnection connection = new PqsqlConnection(connectionString))
+			{
+				await connection.OpenAsync();
+				Assert.AreEqual(ConnectionState.Open, connection.State, "wrong connection state");
+
+				int client_encoding = PqsqlWrapper.PQclientEncoding(connection.PGConnection);
+				Assert.AreEqual((int) PgEnc.PG_UTF8, client_encoding, "wrong client_encoding");
+
+				PqsqlCommand cmd = connection.CreateCommand();
+				cmd.CommandText = "select 42";
+				Assert.AreEqual(42, cmd.ExecuteScalar());
+			}
+
+			// open many connections at once
+			PqsqlConnection[] connections = new PqsqlConnection[20];
+			Task[] opening = new Task[connections.Length];
+
+			for (int i = 0; i < connections.Length; i++)
+			{
+				connections[i] = new PqsqlConnection(connectionString);
+				opening[i] = connections[i].OpenAsync();
+			}
+
+			await Task.WhenAll(opening);
+
+			foreach (PqsqlConnection c in connections)
+			{
+				Assert.AreEqual(ConnectionState.Open, c.State, "wrong connection state");
+				c.Dispose();
+			}
+
+			using (PqsqlConnection connection = new PqsqlConnection(connectionString))
+			using (CancellationTokenSource cts = new CancellationTokenSource())
+			{
+				cts.Cancel();
+
+				try
+				{
+					await connection.OpenAsync(cts.Token);
+					Assert.Fail();
+				}
+				catch (OperationCanceledException)
+				{
+				}
+
+				Assert.AreEqual(ConnectionState.Closed, connection.State, "wrong connection state");
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlConnectionTest12()
+		{
+			PqsqlConnectionPool.Clear();
+
+			PqsqlConnection c1 = new PqsqlConnection(connectionString);
+			PqsqlConnection c2 = new PqsqlConnection(connectionString);
+
+			c1.Open();
+			c2.Open();
+
+			IntPtr pg1 = c1.PGConnection;
+			IntPtr pg2 = c2.PGConnection;
+			Assert.AreNotEqual(pg1, pg2);
+
+			c1.Close();
+			c2.Close();
+
+			// the most recently released connection is handed out first
+			c1.Open();
+			Assert.AreEqual(pg2, c1.PGConnection, "connection was not received from top of connection pool");
+
+			c2.Open();
+			Assert.AreEqual(pg1, c2.PGConnection, "connection was not received from internal connection pool");
+
+			c1.Close();
+			c2.Close();
+
+			// a changed connection string uses a different pool
+			c1.ConnectionString = connectionString + ";application_name=pooltest";
+			c1.Open();
+			Assert.AreNotEqual(pg1, c1.PGConnection);
+			Assert.AreNotEqual(pg2, c1.PGConnection);
+			c1.Close();
+		}
+
+		[TestMethod]
+		public void PqsqlConnectionTest13()
+		{
+			PqsqlConnectionPool.Clear();
+
+			string cs = connectionString + ";validation_interval=60000";
+
+			PqsqlConnection c1 = new PqsqlConnection(cs);
+			PqsqlConnection c2 = new PqsqlConnection(connectionString);
+
+			c1.Open();
+			IntPtr pg1 = c1.PGConnection;
+
+			PqsqlCommand cmd = new PqsqlCommand("select pg_backend_pid()", c1);
+			int pid = (int) cmd.ExecuteScalar();
+			c1.Close();
+
+			// recently released connection is reused without a round trip
+			c1.Open();
+			Assert.AreEqual(pg1, c1.PGConnection, "connection was not received from internal connection pool");
+			Assert.AreEqual(pid, (int) cmd.ExecuteScalar());
+			c1.Close();
+
+			// terminate the pooled connection
+			c2.Open();
+			PqsqlCommand kill = new PqsqlCommand("select pg_terminate_backend(:pid)", c2);
+			kill.Parameters.AddWithValue("pid", pid);
+			Assert.AreEqual(true, kill.ExecuteScalar());
+			c2.Close();
+
+			Thread.Sleep(200); // wait until the backend closed the socket
+
+			// the socket check detects the hangup and reconnects
+			c1.Open();
+			Assert.AreEqual(ConnectionState.Open, c1.State);
+			int pid2 = (int) cmd.ExecuteScalar();
+			Assert.AreNotEqual(pid, pid2);
+			c1.Close();
+		}
+
+		[TestMethod]
+		public void PqsqlConnectionTest14()
+		{
+			const string countPrepared = "select count(*) from pg_prepared_statements where name like 'pqsql\\_%'";
+
+			PqsqlConnectionPool.Clear();
+
+			// reset_all keeps prepared statements, but resets session parameters
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";session_reset=reset_all"))
+			{
+				PqsqlCommand prep = new PqsqlCommand("select :p1 + 1", conn);
+				prep.Parameters.AddWithValue("p1", 41).DbType = DbType.Int32;
+				prep.Prepare();
+				Assert.AreEqual(42, prep.ExecuteScalar());
+
+				new PqsqlCommand("set work_mem = '1234kB'", conn).ExecuteNonQuery();
+				IntPtr pg = conn.PGConnection;
+				conn.Close();
+
+				conn.Open();
+				Assert.AreEqual(pg, conn.PGConnection, "connection was not received from internal connection pool");
+				Assert.AreNotEqual("1234kB", new PqsqlCommand("show work_mem", conn).ExecuteScalar());
+				Assert.AreEqual(1L, new PqsqlCommand(countPrepared, conn).ExecuteScalar());
+
+				// the statement cache moved with the connection, no name clashes
+				PqsqlCommand prep2 = new PqsqlCommand("select :p1 + 2", conn);
+				prep2.Parameters.AddWithValue("p1", 40).DbType = DbType.Int32;
+				prep2.Prepare();
+				Assert.AreEqual(42, prep2.ExecuteScalar());
+				Assert.AreEqual(42, prep.ExecuteScalar());
+			}
+
+			// changed only discards sessions which executed commands changing the session state
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";session_reset=changed"))
+			{
+				PqsqlCommand prep = new PqsqlCommand("select :p1 + 1", conn);
+				prep.Parameters.AddWithValue("p1", 41).DbType = DbType.Int32;
+				prep.Prepare();
+				Assert.AreEqual(42, prep.ExecuteScalar());
+				conn.Close();
+
+				conn.Open();
+				Assert.AreEqual(1L, new PqsqlCommand(countPrepared, conn).ExecuteScalar());
+
+				new PqsqlCommand("set work_mem = '1234kB'", conn).ExecuteNonQuery();
+				conn.Close();
+
+				conn.Open();
+				Assert.AreNotEqual("1234kB", new PqsqlCommand("show work_mem", conn).ExecuteScalar());
+				Assert.AreEqual(0L, new PqsqlCommand(countPrepared, conn).ExecuteScalar());
+				Assert.AreEqual(42, prep.ExecuteScalar());
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlConnectionTest15()
+		{
+			string cs = connectionString + ";min_pool_size=3;max_pool_size=4";
+			PqsqlConnectionPool.ConnectionPool pool = PqsqlConnectionPool.GetPool(new PqsqlConnectionStringBuilder(cs));
+
+			// GetPool() started to open MinPoolSize connections in the background
+			for (int i = 0; i < 100 && Volatile.Read(ref pool.Count) < 3; i++)
+			{
+				Thread.Sleep(50);
+			}
+
+			Assert.AreEqual(3, pool.Count);
+			Assert.AreEqual(3, pool.Total);
+
+			PqsqlConnection[] conns = new PqsqlConnection[4];
+			for (int i = 0; i < conns.Length; i++)
+			{
+				conns[i] = new PqsqlConnection(cs);
+				conns[i].Open();
+			}
+
+			// one new connection, nothing left in the pool
+			Assert.AreEqual(0, pool.Count);
+			Assert.AreEqual(4, pool.Total);
+
+			// all connections in use: Open() gives up after connect_timeout seconds
+			PqsqlConnection c5 = new PqsqlConnection(cs);
+			try
+			{
+				c5.Open();
+				Assert.Fail("opened more than max_pool_size connections");
+			}
+			catch (PqsqlException)
+			{
+			}
+
+			Assert.AreEqual(4, pool.Total);
+
+			foreach (PqsqlConnection c in conns)
+			{
+				c.Close();
+			}
+
+			Assert.AreEqual(4, pool.Count);
+			Assert.AreEqual(4, pool.Total);
+		}
+
+		[TestMethod]
+		public async Task PqsqlConnectionTest16()
+		{
+			string cs = connectionString + ";max_pool_size=1";
+
+			PqsqlConnection c1 = new PqsqlConnection(cs);
+			PqsqlConnection c2 = new PqsqlConnection(cs);
+			PqsqlConnection c3 = new PqsqlConnection(cs);
+
+			c1.Open();
+			IntPtr pg = c1.PGConnection;
+
+			// both wait for the only connection of the pool
+			Task t2 = c2.OpenAsync();
+			Task t3 = c3.OpenAsync();
+			Assert.IsFalse(t2.IsCompleted);
+			Assert.IsFalse(t3.IsCompleted);
+
+			// released connections are handed to the waiters in FIFO order
+			c1.Close();
+			await t2;
+			Assert.AreEqual(pg, c2.PGConnection);
+			Assert.IsFalse(t3.IsCompleted);
+
+			c2.Close();
+			await t3;
+			Assert.AreEqual(pg, c3.PGConnection);
+			Assert.AreEqual(ConnectionState.Open, c3.State);
+
+			c3.Close();
+		}
+
+		[TestMethod]
+		public async Task PqsqlConnectionTest17()
+		{
+			string cs = connectionString + ";multiplexing=2;max_pool_size=3";
+
+			const int n = 20;
+			PqsqlConnection[] conns = new PqsqlConnection[n];
+			Task<object>[] results = new Task<object>[n];
+
+			for (int i = 0; i < n; i++)
+			{
+				// multiplexed connections take no connection from the pool
+				conns[i] = new PqsqlConnection(cs);
+				conns[i].Open();
+				Assert.AreEqual(ConnectionState.Open, conns[i].State);
+
+				PqsqlCommand cmd = new PqsqlCommand("select :i", conns[i]);
+				cmd.Parameters.Add(new PqsqlParameter("i", DbType.Int32) { Value = i });
+				results[i] = cmd.ExecuteScalarAsync();
+			}
+
+			for (int i = 0; i < n; i++)
+			{
+				Assert.AreEqual(i, await results[i]);
+			}
+
+			// a failed command does not affect the other commands of the shared connection
+			PqsqlCommand err = new PqsqlCommand("select 1/0", conns[0]);
+			Task<object> failed = err.ExecuteScalarAsync();
+			Task<int> affected = new PqsqlCommand("select 1", conns[1]).ExecuteNonQueryAsync();
+
+			try
+			{
+				await failed;
+				Assert.Fail("division by zero expected");
+			}
+			catch (PqsqlException)
+			{
+			}
+
+			Assert.AreEqual(-1, await affected);
+			Assert.AreEqual(42, new PqsqlCommand("select 42", conns[2]).ExecuteScalar());
+
+			// transactions take a connection of their own from the pool
+			PqsqlTransaction tran = conns[3].BeginTransaction();
+			Assert.AreNotEqual(IntPtr.Zero, conns[3].PGConnection);
+			PqsqlCommand set = new PqsqlCommand("set local statement_timeout=1000", conns[3]) { Transaction = tran };
+			set.ExecuteNonQuery();
+			tran.Rollback();
+
+			// and keep it until Close()
+			Assert.AreEqual(ConnectionState.Open, conns[3].State);
+			Assert.AreNotEqual(IntPtr.Zero, conns[3].PGConnection);
+
+			// commands which might change the session state pin a connection, too
+			Assert.IsTrue(PqsqlConnection.IsMultiplexed("select 1"));
+			Assert.IsTrue(PqsqlConnection.IsMultiplexed("insert into t values (1)"));
+			Assert.IsFalse(PqsqlConnection.IsMultiplexed("begin"));
+			Assert.IsFalse(PqsqlConnection.IsMultiplexed("listen ch"));
+			Assert.IsFalse(PqsqlConnection.IsMultiplexed("create temp table t (i int4)"));
+			Assert.IsFalse(PqsqlConnection.IsMultiplexed("select 1 into temp t"));
+
+			conns[3].Close(); // max_pool_size=3 connections: 2 shared, 1 pinned
+			Assert.IsTrue(conns[4].Multiplexed);
+			new PqsqlCommand("set application_name = 'pinned'", conns[4]).ExecuteNonQuery();
+			Assert.IsFalse(conns[4].Multiplexed);
+			Assert.AreEqual("pinned", new PqsqlCommand("show application_name", conns[4]).ExecuteScalar());
+
+			foreach (PqsqlConnection conn in conns)
+			{
+				conn.Close();
+				Assert.AreEqual(ConnectionState.Closed, conn.State);
+			}
+		}
 	}
 }
@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Data;
+using System.IO;
 using System.Text;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
@@ -506,5 +507,276 @@ namespace PqsqlTests
 				tran?.Dispose();
 			}
 		}
+
+		[TestMethod]
+		public void PqsqlCopyFromTest10()
+		{
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "CREATE TEMP TABLE temp (id int4, blob bytea)";
+			mCmd.CommandTimeout = 200;
+			mCmd.CommandType = CommandType.Text;
+
+			int q = mCmd.ExecuteNonQuery();
+			Assert.AreEqual(0, q);
+
+			PqsqlCopyFrom copy = new PqsqlCopyFrom(mConnection)
+			{
+				Table = "temp",
+				CopyTimeout = 30,
+				BufferSize = 64 * 1024
+			};
+
+			copy.Start();
+
+			// mix of buffered values and values sent directly (> BufferSize / 2)
+			int[] sizes = { 0, 1, 1000, 32 * 1024, 100000, 3 * 1024 * 1024 };
+
+			for (int i = 0; i < sizes.Length; i++)
+			{
+				byte[] b = new byte[sizes[i]];
+				for (int j = 0; j < b.Length; j++)
+				{
+					b[j] = (byte) (i + j);
+				}
+
+				copy.WriteInt4(i);
+				int k = copy.WriteBytes(b);
+				Assert.AreEqual(sizes[i], k);
+			}
+			copy.WriteInt4(sizes.Length);
+			copy.WriteBytes(null);
+			copy.End();
+			copy.Close();
+
+			mCmd.CommandText = "select id, blob from temp order by id";
+			mCmd.CommandType = CommandType.Text;
+
+			PqsqlDataReader r = mCmd.ExecuteReader();
+
+			int n = 0;
+			while (r.Read())
+			{
+				Assert.AreEqual(n, r.GetInt32(0));
+
+				if (n == sizes.Length)
+				{
+					Assert.IsTrue(r.IsDBNull(1));
+				}
+				else
+				{
+					byte[] b = (byte[]) r.GetValue(1);
+					Assert.AreEqual(sizes[n], b.Length);
+
+					for (int j = 0; j < b.Length; j++)
+					{
+						Assert.AreEqual((byte) (n + j), b[j]);
+					}
+				}
+
+				n++;
+			}
+
+			Assert.AreEqual(sizes.Length + 1, n);
+
+			tran.Rollback();
+		}
+
+		[TestMethod]
+		public void PqsqlCopyFromTest11()
+		{
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "CREATE TEMP TABLE temp (a int4, b int8, c float8, d bool, e text, f timestamp, g bytea)";
+			mCmd.CommandTimeout = 200;
+			mCmd.CommandType = CommandType.Text;
+
+			int q = mCmd.ExecuteNonQuery();
+			Assert.AreEqual(0, q);
+
+			PqsqlCopyFrom copy = new PqsqlCopyFrom(mConnection)
+			{
+				Table = "temp",
+				CopyTimeout = 30
+			};
+
+			copy.Start();
+
+			const int n = 1000;
+			int[] a = new int[n];
+			long[] b = new long[n];
+			double[] c = new double[n];
+			bool[] d = new bool[n];
+			string[] e = new string[n];
+			DateTime[] f = new DateTime[n];
+			byte[][] g = new byte[n][];
+			byte[] anull = new byte[(n + 7) / 8];
+
+			DateTime ts = new DateTime(2017, 3, 4, 5, 6, 7, 8);
+
+			for (int i = 0; i < n; i++)
+			{
+				a[i] = i;
+				b[i] = (long) i << 33;
+				c[i] = i / 3.0;
+				d[i] = i % 2 == 0;
+				e[i] = i % 10 == 0 ? null : "text ü " + i;
+				f[i] = ts.AddSeconds(i);
+				g[i] = i % 7 == 0 ? null : BitConverter.GetBytes(i);
+
+				if (i % 5 == 0)
+					anull[i >> 3] |= (byte) (1 << (i & 7));
+			}
+
+			// write the batch twice, mixed with single values in between
+			int rows = copy.WriteBatch(new Array[] { a, b, c, d, e, f, g }, new[] { anull, null, null, null, null, null, null });
+			Assert.AreEqual(n, rows);
+
+			copy.WriteInt4(-1);
+			copy.WriteInt8(-1);
+			copy.WriteFloat8(-1);
+			copy.WriteBool(false);
+			copy.WriteText("single");
+			copy.WriteTimestamp(ts);
+			copy.WriteNull();
+
+			rows = copy.WriteBatch(new Array[] { a, b, c, d, e, f, g });
+			Assert.AreEqual(n, rows);
+
+			copy.End();
+			copy.Close();
+
+			mCmd.CommandText = "select count(*), count(a), sum(b), count(e), count(g), max(f) from temp";
+			mCmd.CommandType = CommandType.Text;
+
+			using (PqsqlDataReader r = mCmd.ExecuteReader())
+			{
+				Assert.IsTrue(r.Read());
+				Assert.AreEqual(2 * n + 1, r.GetInt64(0));
+				Assert.AreEqual(2 * n + 1 - n / 5, r.GetInt64(1));
+				Assert.AreEqual(2 * n + 1 - 2 * (n / 10), r.GetInt64(3));
+				Assert.AreEqual(2 * n - 2 * ((n + 6) / 7), r.GetInt64(4));
+				Assert.AreEqual(ts.AddSeconds(n - 1), r.GetDateTime(5));
+			}
+
+			mCmd.CommandText = "select a, b, c, d, e, g from temp where b = " + (123L << 33) + " limit 1";
+
+			using (PqsqlDataReader r = mCmd.ExecuteReader())
+			{
+				Assert.IsTrue(r.Read());
+				Assert.AreEqual(123, r.GetInt32(0));
+				Assert.AreEqual(123 / 3.0, r.GetDouble(2));
+				Assert.IsFalse(r.GetBoolean(3));
+				Assert.AreEqual("text ü 123", r.GetString(4));
+				CollectionAssert.AreEqual(BitConverter.GetBytes(123), (byte[]) r.GetValue(5));
+			}
+
+			tran.Rollback();
+		}
+
+		[TestMethod]
+		public void PqsqlCopyFromTest12()
+		{
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "create temporary table src (a int4, b text); " +
+							   "create temporary table dst (a int4, b text); " +
+							   "insert into src select i, case when i % 4 = 0 then null else 'text, \"quoted\" ' || i end from generate_series(1, 5000) i;";
+			mCmd.CommandType = CommandType.Text;
+			mCmd.ExecuteNonQuery();
+
+			foreach (PqsqlCopyFormat format in new[] { PqsqlCopyFormat.Binary, PqsqlCopyFormat.Text, PqsqlCopyFormat.Csv })
+			{
+				using (MemoryStream ms = new MemoryStream())
+				{
+					PqsqlCopyTo copyTo = new PqsqlCopyTo(mConnection)
+					{
+						Table = "src",
+						CopyTimeout = 10,
+						Format = format
+					};
+
+					copyTo.Start();
+					long written = copyTo.CopyToStream(ms);
+					copyTo.Close();
+
+					Assert.AreEqual(ms.Length, written);
+
+					ms.Position = 0;
+
+					PqsqlCopyFrom copyFrom = new PqsqlCopyFrom(mConnection)
+					{
+						Table = "dst",
+						CopyTimeout = 10,
+						Format = format
+					};
+
+					copyFrom.Start();
+					long read = copyFrom.CopyFromStream(ms);
+					copyFrom.Close();
+
+					Assert.AreEqual(written, read);
+				}
+
+				mCmd.CommandText = "select count(*) from (select * from src except all select * from dst) d";
+				Assert.AreEqual(0L, mCmd.ExecuteScalar());
+
+				mCmd.CommandText = "select count(*), count(b) from dst";
+				using (PqsqlDataReader r = mCmd.ExecuteReader())
+				{
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(5000L, r.GetInt64(0));
+					Assert.AreEqual(3750L, r.GetInt64(1));
+				}
+
+				mCmd.CommandText = "truncate dst";
+				mCmd.ExecuteNonQuery();
+			}
+
+			tran.Rollback();
+		}
+
+		[TestMethod]
+		public void PqsqlCopyFromTest13()
+		{
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "create temporary table dst (a int4)";
+			mCmd.CommandType = CommandType.Text;
+			mCmd.ExecuteNonQuery();
+
+			PqsqlCopyFrom copyFrom = new PqsqlCopyFrom(mConnection)
+			{
+				Table = "dst",
+				CopyTimeout = 10,
+				Format = PqsqlCopyFormat.Csv
+			};
+
+			copyFrom.Start();
+
+			bool thrown = false;
+			try
+			{
+				copyFrom.WriteInt4(1);
+			}
+			catch (InvalidOperationException)
+			{
+				thrown = true;
+			}
+			Assert.IsTrue(thrown, "Write methods must be rejected for csv COPY");
+
+			// End must finish the csv COPY without data
+			copyFrom.End();
+			copyFrom.Close();
+
+			mCmd.CommandText = "select count(*) from dst";
+			Assert.AreEqual(0L, mCmd.ExecuteScalar());
+
+			tran.Rollback();
+		}
 	}
 }
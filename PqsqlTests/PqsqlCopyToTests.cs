@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Data;
+using System.Threading.Tasks;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
 
@@ -1067,5 +1068,135 @@ namespace PqsqlTests
 			copy.Close();
 			tran.Rollback();
 		}
+
+		/// <summary>
+		/// Test batches of rows read into column arrays, mixed with FetchRow
+		/// </summary>
+		[TestMethod]
+		public void PqsqlCopyToTest15()
+		{
+			const int len = 1000;
+
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "create temporary table foo (a int4, b text, c float8, d timestamp, e bytea); " +
+							   "insert into foo select i, case when i % 3 = 0 then null else repeat('x', i) end, i / 2.0, " +
+							   "'2017-01-01'::timestamp + i * interval '1 second', case when i % 5 = 0 then null else int4send(i) end " +
+							   "from generate_series(0, " + (len - 1) + ") i;";
+			mCmd.CommandType = CommandType.Text;
+			int affected = mCmd.ExecuteNonQuery();
+			Assert.AreEqual(len, affected);
+
+			var copy = new PqsqlCopyTo(mConnection)
+			{
+				Table = "foo",
+				CopyTimeout = 10,
+			};
+
+			copy.Start();
+
+			// first row with the per-cell interface
+			Assert.IsTrue(copy.FetchRow());
+			Assert.AreEqual(0, copy.ReadInt4());
+
+			int[] a = new int[64];
+			string[] b = new string[64];
+			double[] c = new double[64];
+			DateTime[] d = new DateTime[64];
+			byte[][] e = new byte[64][];
+			byte[] anull = new byte[8];
+			byte[] bnull = new byte[8];
+
+			DateTime ts = new DateTime(2017, 1, 1);
+			int row = 1;
+			int n;
+
+			while ((n = copy.ReadBatch(new Array[] { a, b, c, d, e }, new[] { anull, bnull, null, null, null })) > 0)
+			{
+				for (int i = 0; i < n; i++, row++)
+				{
+					Assert.AreEqual(row, a[i]);
+					Assert.AreEqual(0, anull[i >> 3] & (1 << (i & 7)));
+					Assert.AreEqual(row % 3 == 0, (bnull[i >> 3] & (1 << (i & 7))) != 0);
+					Assert.AreEqual(row % 3 == 0 ? null : new string('x', row), b[i]);
+					Assert.AreEqual(row / 2.0, c[i]);
+					Assert.AreEqual(ts.AddSeconds(row), d[i]);
+
+					if (row % 5 == 0)
+					{
+						Assert.IsNull(e[i]);
+					}
+					else
+					{
+						Assert.AreEqual(4, e[i].Length);
+						Assert.AreEqual(row, (e[i][0] << 24) | (e[i][1] << 16) | (e[i][2] << 8) | e[i][3]);
+					}
+				}
+			}
+
+			Assert.AreEqual(len, row);
+
+			// the end of the COPY data is sticky
+			Assert.AreEqual(0, copy.ReadBatch(new Array[] { a, b, c, d, e }));
+
+			copy.Close();
+			tran.Rollback();
+		}
+
+		/// <summary>
+		/// Test asynchronous fetching with a small prefetch queue
+		/// </summary>
+		[TestMethod]
+		public void PqsqlCopyToTest16()
+		{
+			const int len = 10000;
+
+			PqsqlTransaction tran = mConnection.BeginTransaction();
+			mCmd.Transaction = tran;
+
+			mCmd.CommandText = "create temporary table foo (a int4, b text); " +
+							   "insert into foo select i, 'row ' || i from generate_series(0, " + (len - 1) + ") i;";
+			mCmd.CommandType = CommandType.Text;
+			int affected = mCmd.ExecuteNonQuery();
+			Assert.AreEqual(len, affected);
+
+			var copy = new PqsqlCopyTo(mConnection)
+			{
+				Table = "foo",
+				CopyTimeout = 10,
+				PrefetchCount = 16,
+			};
+
+			copy.Start();
+
+			int row = 0;
+			while (copy.FetchRowAsync().GetAwaiter().GetResult())
+			{
+				Assert.AreEqual(row, copy.ReadInt4());
+				Assert.AreEqual("row " + row, copy.ReadString());
+				row++;
+
+				// synchronous fetching continues with the prefetched rows
+				if (row == len / 2)
+				{
+					Assert.IsTrue(copy.FetchRow());
+					Assert.AreEqual(row, copy.ReadInt4());
+					Assert.AreEqual("row " + row, copy.ReadString());
+					row++;
+				}
+			}
+
+			Assert.AreEqual(len, row);
+
+			// further calls do not wait for data after the end of the COPY data
+			Task<bool> end = copy.FetchRowAsync();
+			Assert.IsTrue(end.Wait(5000));
+			Assert.IsFalse(end.Result);
+			Assert.IsFalse(copy.FetchRow());
+
+			copy.Close();
+			tran.Rollback();
+		}
 	}
 }
@@ -2,6 +2,9 @@
 using System.Collections;
 using System.Data;
 using System.Data.Common;
+using System.Globalization;
+using System.Threading;
+using System.Threading.Tasks;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
 
@@ -739,5 +742,313 @@ namespace PqsqlTests
 				reader.Close();
 			}
 		}
+
+		[TestMethod]
+		public void PqsqlDataReaderTest13()
+		{
+			decimal[] vals = {
+				decimal.MaxValue,
+				decimal.MinValue,
+				0.0000000000000000000000000001M,
+				-1234567898765432123456.7890123M,
+				123.4560M,
+				-0.5M,
+				0M,
+				10000M,
+				7.9228162514264337593543950335M
+			};
+
+			mCmd.CommandText = "select :p0, :p1, :p2, :p3, :p4, :p5, :p6, :p7, :p8, '1.23456789012345678901234567895'::numeric, '-0.00000000000000000000000000005'::numeric, " +
+				"'{1.5,NULL,-2.25}'::numeric[], :s0, :s1";
+
+			for (int i = 0; i < vals.Length; i++)
+			{
+				mCmd.Parameters.Add(new PqsqlParameter
+				{
+					ParameterName = ":p" + i,
+					PqsqlDbType = PqsqlDbType.Numeric,
+					Value = vals[i]
+				});
+			}
+
+			// strings are parsed as decimal, or encoded through double if they have no decimal representation
+			mCmd.Parameters.Add(new PqsqlParameter { ParameterName = ":s0", PqsqlDbType = PqsqlDbType.Numeric, Value = "1e5" });
+			mCmd.Parameters.Add(new PqsqlParameter { ParameterName = ":s1", PqsqlDbType = PqsqlDbType.Numeric, Value = "NaN" });
+
+			using (PqsqlDataReader reader = mCmd.ExecuteReader())
+			{
+				Assert.IsTrue(reader.Read());
+
+				for (int i = 0; i < vals.Length; i++)
+				{
+					decimal dec = reader.GetDecimal(i);
+					Assert.AreEqual(vals[i], dec);
+					// scale survives the round trip
+					Assert.AreEqual(vals[i].ToString(CultureInfo.InvariantCulture), dec.ToString(CultureInfo.InvariantCulture));
+				}
+
+				// rounded half away from zero to 28 fractional digits
+				Assert.AreEqual(1.2345678901234567890123456790M, reader.GetDecimal(vals.Length));
+				Assert.AreEqual(-0.0000000000000000000000000001M, reader.GetDecimal(vals.Length + 1));
+
+				// GetValue() takes the exact decimal path as well
+				Assert.AreEqual(1.2345678901234567890123456790M, reader.GetValue(vals.Length));
+
+				// numeric arrays are decoded as decimal, too
+				Array arr = (Array) reader.GetValue(vals.Length + 2);
+				Assert.AreEqual(typeof(decimal?), arr.GetType().GetElementType());
+				Assert.AreEqual(1.5M, arr.GetValue(1));
+				Assert.IsNull(arr.GetValue(2));
+				Assert.AreEqual(-2.25M, arr.GetValue(3));
+
+				Assert.AreEqual(100000M, reader.GetDecimal(vals.Length + 3));
+
+				// NaN has no decimal representation
+				Assert.AreEqual(double.NaN, reader.GetDouble(vals.Length + 4));
+				try
+				{
+					reader.GetValue(vals.Length + 4);
+					Assert.Fail("NaN cannot be represented as decimal");
+				}
+				catch (OverflowException)
+				{
+				}
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlDataReaderTest14()
+		{
+			PqsqlTransaction t = mConnection.BeginTransaction();
+			mCmd.Transaction = t;
+
+			mCmd.CommandText = @"declare c cursor for
+				select i::int4, case when i % 3 = 0 then null else i::float8 end, timestamp '2000-01-01' + i * interval '1 day', date '2000-01-01' + i
+				from generate_series(1, 100) i";
+			mCmd.ExecuteNonQuery();
+
+			// fetch statements do not run in single row mode, all 100 rows are in the result buffer
+			mCmd.CommandText = "fetch all from c";
+
+			using (PqsqlDataReader reader = mCmd.ExecuteReader())
+			{
+				Assert.IsTrue(reader.Read());
+				Assert.AreEqual(100, reader.BufferedRowCount);
+
+				int[] ints = new int[101];
+				Assert.AreEqual(100, reader.GetColumn(0, ints, 1, null));
+
+				double[] doubles = new double[100];
+				byte[] nullmap = new byte[13];
+				Assert.AreEqual(100, reader.GetColumn(1, doubles, 0, nullmap));
+
+				DateTime[] timestamps = new DateTime[50];
+				Assert.AreEqual(50, reader.GetColumn(2, timestamps, 0, null));
+
+				DateTime[] dates = new DateTime[100];
+				Assert.AreEqual(100, reader.GetColumn(3, dates, 0, null));
+
+				for (int i = 0; i < 100; i++)
+				{
+					Assert.AreEqual(i + 1, ints[i + 1]);
+
+					bool isNull = (nullmap[i >> 3] & (1 << (i & 7))) != 0;
+					Assert.AreEqual((i + 1) % 3 == 0, isNull);
+					Assert.AreEqual(isNull ? 0.0 : i + 1, doubles[i]);
+
+					if (i < 50)
+						Assert.AreEqual(new DateTime(2000, 1, 1).AddDays(i + 1), timestamps[i]);
+
+					Assert.AreEqual(new DateTime(2000, 1, 1).AddDays(i + 1), dates[i]);
+				}
+
+				// the current row does not change
+				Assert.AreEqual(1, reader.GetInt32(0));
+
+				// wrong datatype
+				try
+				{
+					reader.GetColumn(0, new long[100], 0, null);
+					Assert.Fail();
+				}
+				catch (PqsqlException)
+				{
+				}
+
+				Assert.IsTrue(reader.Read());
+				Assert.AreEqual(99, reader.BufferedRowCount);
+				Assert.AreEqual(99, reader.GetColumn(0, ints, 0, null));
+				Assert.AreEqual(2, ints[0]);
+			}
+
+			t.Rollback();
+		}
+
+		[TestMethod]
+		public void PqsqlDataReaderTest15()
+		{
+			mCmd.CommandText = "select array(select i::float8 / 4 from generate_series(1, 10000) i), array(select i::int4 from generate_series(-3, 5) i), array[1, null, 3]::int8[], '{}'::int2[] || 7::int2";
+
+			using (PqsqlDataReader reader = mCmd.ExecuteReader())
+			{
+				Assert.IsTrue(reader.Read());
+
+				// arrays without NULL values are decoded in one go
+				Array f8 = (Array) reader.GetValue(0);
+				Assert.AreEqual(typeof(double), f8.GetType().GetElementType());
+				Assert.AreEqual(10000, f8.Length);
+				Assert.AreEqual(1, f8.GetLowerBound(0));
+				for (int i = 1; i <= 10000; i++)
+				{
+					Assert.AreEqual(i / 4.0, f8.GetValue(i));
+				}
+
+				Array i4 = (Array) reader.GetValue(1);
+				Assert.AreEqual(typeof(int), i4.GetType().GetElementType());
+				Assert.AreEqual(9, i4.Length);
+				for (int i = 1; i <= 9; i++)
+				{
+					Assert.AreEqual(i - 4, i4.GetValue(i));
+				}
+
+				// arrays with NULL values use nullable items
+				Array i8 = (Array) reader.GetValue(2);
+				Assert.AreEqual(typeof(long?), i8.GetType().GetElementType());
+				Assert.AreEqual(1L, i8.GetValue(1));
+				Assert.IsNull(i8.GetValue(2));
+				Assert.AreEqual(3L, i8.GetValue(3));
+
+				Array i2 = (Array) reader.GetValue(3);
+				Assert.AreEqual((short) 7, i2.GetValue(1));
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlDataReaderTest16()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString + ";result_chunk_size=100"))
+			using (PqsqlCommand cmd = new PqsqlCommand("select i, 'row ' || i from generate_series(1, 1050) i; select 1 where false; select 42", conn))
+			using (PqsqlDataReader r = cmd.ExecuteReader())
+			{
+				int n = 0;
+				while (r.Read())
+				{
+					n++;
+					Assert.IsTrue(r.BufferedRowCount <= 100);
+					Assert.AreEqual(n, r.GetInt32(0));
+					Assert.AreEqual("row " + n, r.GetString(1));
+				}
+				Assert.AreEqual(1050, n);
+
+				// empty result
+				Assert.IsTrue(r.NextResult());
+				Assert.IsFalse(r.Read());
+
+				Assert.IsTrue(r.NextResult());
+				Assert.IsTrue(r.Read());
+				Assert.AreEqual(42, r.GetInt32(0));
+				Assert.IsFalse(r.Read());
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlDataReaderTest17()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString))
+			using (PqsqlCommand cmd = new PqsqlCommand("select i from generate_series(1, 10) i; select 42", conn))
+			{
+				cmd.BufferedResults = true;
+
+				using (PqsqlDataReader r = cmd.ExecuteReader())
+				{
+					int n = 0;
+					while (r.Read())
+					{
+						n++;
+						// the current row and all rows after it are buffered
+						Assert.AreEqual(10 - (n - 1), r.BufferedRowCount);
+						Assert.AreEqual(n, r.GetInt32(0));
+					}
+					Assert.AreEqual(10, n);
+
+					Assert.IsTrue(r.NextResult());
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(42, r.GetInt32(0));
+					Assert.IsFalse(r.Read());
+				}
+
+				cmd.BufferedResults = false;
+				cmd.CommandText = "select i from generate_series(1, 3) i";
+
+				// SingleRow reads the fully materialized result set, too
+				using (PqsqlDataReader r = cmd.ExecuteReader(CommandBehavior.SingleRow))
+				{
+					Assert.IsTrue(r.Read());
+					Assert.AreEqual(3, r.BufferedRowCount);
+					Assert.AreEqual(1, r.GetInt32(0));
+				}
+			}
+		}
+
+		[TestMethod]
+		public async Task PqsqlDataReaderTest18()
+		{
+			using (PqsqlConnection conn = new PqsqlConnection(connectionString))
+			using (PqsqlCommand cmd = new PqsqlCommand("select i from pg_sleep(0.2), generate_series(1, 100) i; select 1 where false; select :p", conn))
+			{
+				cmd.Parameters.AddWithValue("p", "async").DbType = DbType.String;
+
+				using (PqsqlDataReader r = await cmd.ExecuteReaderAsync())
+				{
+					int n = 0;
+					while (await r.ReadAsync())
+					{
+						Assert.AreEqual(++n, r.GetInt32(0));
+					}
+					Assert.AreEqual(100, n);
+
+					Assert.IsTrue(await r.NextResultAsync());
+					Assert.IsFalse(await r.ReadAsync());
+
+					Assert.IsTrue(await r.NextResultAsync());
+					Assert.IsTrue(await r.ReadAsync());
+					Assert.AreEqual("async", r.GetString(0));
+					Assert.IsFalse(await r.ReadAsync());
+					Assert.IsFalse(await r.NextResultAsync());
+				}
+
+				// errors surface from the returned tasks
+				cmd.CommandText = "select 1/0";
+				cmd.Parameters.Clear();
+
+				try
+				{
+					await cmd.ExecuteReaderAsync();
+					Assert.Fail();
+				}
+				catch (PqsqlException e)
+				{
+					Assert.AreEqual((int) PqsqlState.DIVISION_BY_ZERO, e.ErrorCode);
+				}
+
+				// cancellation cancels the running statement, the connection stays usable
+				cmd.CommandText = "select pg_sleep(10)";
+
+				using (CancellationTokenSource cts = new CancellationTokenSource(200))
+				{
+					try
+					{
+						await cmd.ExecuteReaderAsync(cts.Token);
+						Assert.Fail();
+					}
+					catch (OperationCanceledException)
+					{
+					}
+				}
+
+				cmd.CommandText = "select 42";
+				Assert.AreEqual(42, cmd.ExecuteScalar());
+			}
+		}
 	}
 }
\ No newline at end of file
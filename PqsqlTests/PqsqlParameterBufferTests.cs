@@ -1,5 +1,7 @@
 using System;
 using System.Data;
+using System.Net;
+using System.Runtime.InteropServices;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using Pqsql;
 
@@ -176,5 +178,101 @@ namespace PqsqlTests
 				Assert.AreNotEqual(IntPtr.Zero, pfrms);
 			}
 		}
+
+		[TestMethod]
+		public void PqsqlParameterBufferTest6()
+		{
+			using (PqsqlParameterBuffer buf = new PqsqlParameterBuffer())
+			{
+				buf.AddParameter(new PqsqlParameter { ParameterName = "p1", PqsqlDbType = PqsqlDbType.Array | PqsqlDbType.Int8, Value = new long[] { 1, 2, 3 } });
+				buf.AddParameter(new PqsqlParameter { ParameterName = "p2", PqsqlDbType = PqsqlDbType.Array | PqsqlDbType.Int4, Value = new int?[] { 1, null, 3, 4, 5 } });
+				buf.AddParameter(new PqsqlParameter { ParameterName = "p3", PqsqlDbType = PqsqlDbType.Array | PqsqlDbType.Float8, Value = new double[0] });
+
+				IntPtr ptyps; // oid*
+				IntPtr pvals; // char**
+				IntPtr plens; // int*
+				IntPtr pfrms; // int*
+
+				int num = buf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+				Assert.AreEqual(3, num);
+
+				Assert.AreEqual((int) PqsqlDbType.Int8Array, Marshal.ReadInt32(ptyps, 0));
+				Assert.AreEqual((int) PqsqlDbType.Int4Array, Marshal.ReadInt32(ptyps, 4));
+				Assert.AreEqual((int) PqsqlDbType.Float8Array, Marshal.ReadInt32(ptyps, 8));
+
+				// 20 byte header, itemlength + value for non-null items, itemlength -1 for null items
+				Assert.AreEqual(20 + 3 * 12, Marshal.ReadInt32(plens, 0));
+				Assert.AreEqual(20 + 4 * 8 + 4, Marshal.ReadInt32(plens, 4));
+				Assert.AreEqual(20, Marshal.ReadInt32(plens, 8));
+
+				// array flags: has nulls
+				IntPtr p2 = Marshal.ReadIntPtr(pvals, IntPtr.Size);
+				Assert.AreEqual(1, IPAddress.NetworkToHostOrder(Marshal.ReadInt32(p2, 4)));
+				// second item is null
+				Assert.AreEqual(-1, IPAddress.NetworkToHostOrder(Marshal.ReadInt32(p2, 20 + 8)));
+				// third item is 3
+				Assert.AreEqual(3, IPAddress.NetworkToHostOrder(Marshal.ReadInt32(p2, 20 + 8 + 4 + 4)));
+			}
+		}
+
+		[TestMethod]
+		public void PqsqlParameterBufferTest7()
+		{
+			PqsqlParameterBuffer buf = new PqsqlParameterBuffer();
+
+			IntPtr ptyps; // oid*
+			IntPtr pvals; // char**
+			IntPtr plens; // int*
+			IntPtr pfrms; // int*
+
+			// reserve more parameters than we add and reuse the buffer a couple of times
+			buf.Reserve(4, 1024);
+
+			for (int round = 0; round < 3; round++)
+			{
+				buf.Clear();
+
+				int n = 4 + round * 10; // grows beyond reserved capacity
+
+				for (int i = 0; i < n; i++)
+				{
+					buf.AddParameter(new PqsqlParameter("p" + i, DbType.Int32, round * 1000 + i));
+				}
+
+				int num = buf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+
+				Assert.AreEqual(n, num);
+
+				for (int i = 0; i < n; i++)
+				{
+					Assert.AreEqual((uint) PqsqlDbType.Int4, (uint) Marshal.ReadInt32(ptyps, i * 4));
+					Assert.AreEqual(4, Marshal.ReadInt32(plens, i * 4));
+					Assert.AreEqual(1, Marshal.ReadInt32(pfrms, i * 4));
+
+					IntPtr v = Marshal.ReadIntPtr(pvals, i * IntPtr.Size);
+					Assert.AreEqual(round * 1000 + i, IPAddress.NetworkToHostOrder(Marshal.ReadInt32(v)));
+				}
+			}
+
+			// cannot reserve after parameter values are fixed
+			try
+			{
+				buf.Reserve(100, 0);
+				Assert.Fail();
+			}
+			catch (PqsqlException)
+			{
+			}
+
+			buf.Clear();
+			buf.Reserve(100, 0);
+
+			int num0 = buf.GetQueryParams(out ptyps, out pvals, out plens, out pfrms);
+			Assert.AreEqual(0, num0);
+			Assert.AreEqual(IntPtr.Zero, pvals);
+
+			buf.Dispose();
+		}
 	}
 }
\ No newline at end of file
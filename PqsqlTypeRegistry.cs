@@ -145,15 +145,12 @@ namespace Pqsql
 					TypeValue=new PqsqlTypeValue {
 						DataTypeName="numeric",
 						ProviderType=typeof(Decimal),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetNumeric(res,row,ord,typmod),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetDecimal(res,row,ord), // NaN and Infinity throw like GetDecimal()
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Decimal,
 						ArrayDbType=PqsqlDbType.NumericArray,
-						SetValue=(pb, val, oid) => {
-							double d = Convert.ToDouble(val, CultureInfo.InvariantCulture);
-							PqsqlBinaryFormat.pqbf_add_numeric(pb, d);
-						},
+						SetValue=(pb, val, oid) => PqsqlParameterBuffer.AddNumeric(pb, val),
 						SetArrayItem = PqsqlParameterBuffer.SetNumericArray
 					},
 					DbType=DbType.VarNumeric,
@@ -588,7 +585,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_int2",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int2, typeof(short?), typeof(short), (x, len) => PqsqlBinaryFormat.pqbf_get_int2(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int2, typeof(short?), typeof(short), (x, len) => PqsqlBinaryFormat.pqbf_get_int2(x), sizeof(short)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -604,7 +601,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_int4",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int4, typeof(int?), typeof(int), (x, len) => PqsqlBinaryFormat.pqbf_get_int4(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int4, typeof(int?), typeof(int), (x, len) => PqsqlBinaryFormat.pqbf_get_int4(x), sizeof(int)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -668,7 +665,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_int8",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int8, typeof(long?), typeof(long), (x, len) => PqsqlBinaryFormat.pqbf_get_int8(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Int8, typeof(long?), typeof(long), (x, len) => PqsqlBinaryFormat.pqbf_get_int8(x), sizeof(long)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -684,7 +681,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_float4",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Float4, typeof(float?), typeof(float), (x, len) => PqsqlBinaryFormat.pqbf_get_float4(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Float4, typeof(float?), typeof(float), (x, len) => PqsqlBinaryFormat.pqbf_get_float4(x), sizeof(float)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -700,7 +697,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_float8",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Float8, typeof(double?), typeof(double), (x, len) => PqsqlBinaryFormat.pqbf_get_float8(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Float8, typeof(double?), typeof(double), (x, len) => PqsqlBinaryFormat.pqbf_get_float8(x), sizeof(double)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -716,7 +713,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_oid",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Oid, typeof(uint?), typeof(uint), (x, len) => (uint) PqsqlBinaryFormat.pqbf_get_int4(x)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Oid, typeof(uint?), typeof(uint), (x, len) => (uint) PqsqlBinaryFormat.pqbf_get_int4(x), sizeof(uint)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -873,7 +870,7 @@ namespace Pqsql
 					TypeValue =new PqsqlTypeValue {
 						DataTypeName="_numeric",
 						ProviderType=typeof(Array),
-						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Numeric, typeof(double?), typeof(double), (x, len) => PqsqlBinaryFormat.pqbf_get_numeric(x,typmod)),
+						GetValue=(res, row, ord, typmod) => PqsqlDataReader.GetArrayFill(res, row, ord, PqsqlDbType.Numeric, typeof(decimal?), typeof(decimal), (x, len) => PqsqlDataReader.GetDecimal(x)),
 					},
 					TypeParameter = new PqsqlTypeParameter {
 						TypeCode=TypeCode.Object,
@@ -1014,8 +1011,9 @@ namespace Pqsql
 
 		#region access types for PqsqlDataReader
 
-		// used in PqsqlDataReader.PopulateRowInfoAndOutputParameters
-		internal static PqsqlTypeValue GetOrAdd(PqsqlDbType oid, PqsqlConnection connection)
+		// used in PqsqlDataReader.PopulateRowInfoAndOutputParameters, unknown types are fetched
+		// with a new connection for connectionString
+		internal static PqsqlTypeValue GetOrAdd(PqsqlDbType oid, string connectionString)
 		{
 #if CODECONTRACTS
 			Contract.Ensures(Contract.Result<PqsqlTypeValue>() != null);
@@ -1039,8 +1037,6 @@ namespace Pqsql
 
 			// TODO cache maintainance in mUserTypesDict not implemented
 
-			string connectionString = connection.ConnectionString;
-
 			// try to get user-defined datatype (CREATE TYPE, etc.), whose oid might differ between databases
 			if (mUserTypesDict.TryGetValue(connectionString, out userTypes))
 			{
@@ -1049,7 +1045,7 @@ namespace Pqsql
 					if (!userTypes.TryGetValue(oid, out result))
 					{
 						// if oid is not yet stored, try to find it
-						result = FetchType(oid, connection);
+						result = FetchType(oid, connectionString);
 						userTypes[oid] = result; // store fresh PqsqlTypeEntry here
 					}
 
@@ -1073,7 +1069,7 @@ namespace Pqsql
 					if (!userTypes.TryGetValue(oid, out result))
 					{
 						// if oid is not yet stored, we came first, just try to find oid
-						result = FetchType(oid, connection);
+						result = FetchType(oid, connectionString);
 						userTypes[oid] = result; // store fresh PqsqlTypeEntry here
 					}
 
@@ -1094,7 +1090,7 @@ namespace Pqsql
 					if (!userTypes.TryGetValue(oid, out result))
 					{
 						// if oid is not yet stored, we ran before the TryAdd thread, just try to find oid
-						result = FetchType(oid, connection);
+						result = FetchType(oid, connectionString);
 						userTypes[oid] = result; // store fresh PqsqlTypeEntry here
 					}
 
@@ -1111,12 +1107,12 @@ namespace Pqsql
 			throw new PqsqlException("Could not find datatype " + oid + " for connection " + connectionString);
 		}
 
-		// create new PqsqlTypeEntry for oid in connection
-		private static PqsqlTypeEntry FetchType(PqsqlDbType oid, PqsqlConnection connection)
+		// create new PqsqlTypeEntry for oid in the database of connectionString
+		private static PqsqlTypeEntry FetchType(PqsqlDbType oid, string connectionString)
 		{
 #if CODECONTRACTS
 			Contract.Requires<ArgumentOutOfRangeException>(oid != 0, "Datatype with oid=0 (InvalidOid) not supported");
-			Contract.Requires<ArgumentNullException>(connection != null);
+			Contract.Requires<ArgumentNullException>(connectionString != null);
 
 			Contract.Ensures(Contract.Result<PqsqlTypeEntry>() != null);
 			Contract.Ensures(Contract.Result<PqsqlTypeEntry>().TypeValue != null);
@@ -1129,12 +1125,10 @@ namespace Pqsql
 #else
 			if (oid == 0)
 				throw new ArgumentOutOfRangeException(nameof(oid), "Datatype with oid=0 (InvalidOid) not supported");
-			if (connection == null)
-				throw new ArgumentNullException(nameof(connection));
+			if (connectionString == null)
+				throw new ArgumentNullException(nameof(connectionString));
 #endif
 
-			string connectionString = connection.ConnectionString;
-
 			// try to guess the type mapping
 			// we must open a new connection here, since we have already a running query when we call FetchType
 			// TODO when we have query pipelining, we might not need to open fresh connections here https://commitfest.postgresql.org/10/634/ http://2ndquadrant.github.io/postgres/libpq-batch-mode.html 
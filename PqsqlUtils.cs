@@ -1,5 +1,7 @@
 using System;
+using System.Globalization;
 using System.Runtime.CompilerServices;
+using PqsqlWrapper = Pqsql.UnsafeNativeMethods.PqsqlWrapper;
 
 namespace Pqsql
 {
@@ -110,5 +112,61 @@ namespace Pqsql
 			// swap adjacent 8-bit blocks
 			return ((x & 0xFF00FF00FF00FF00) >> 8) | ((x & 0x00FF00FF00FF00FF) << 8);
 		}
+
+		// current error message of connection conn
+		internal static unsafe string GetErrorMessage(IntPtr conn)
+		{
+			sbyte* b = PqsqlWrapper.PQerrorMessage(conn);
+			return b == null ? string.Empty : PqsqlUTF8Statement.CreateStringFromUTF8(new IntPtr(b));
+		}
+
+		// error message of result res
+		internal static unsafe string GetResultErrorMessage(IntPtr res)
+		{
+			sbyte* m = PqsqlWrapper.PQresultErrorMessage(res);
+			return m == null ? string.Empty : PqsqlUTF8Statement.CreateStringFromUTF8(new IntPtr(m));
+		}
+
+		// RecordsAffected of result res: -1 for SELECT, otherwise the number of affected rows or 0
+		internal static unsafe int GetCmdTuples(IntPtr res)
+		{
+			if (PqsqlWrapper.PQresultStatus(res) != ExecStatusType.PGRES_COMMAND_OK)
+				return -1;
+
+			sbyte* tuples = PqsqlWrapper.PQcmdTuples(res);
+
+			if (tuples == null || *tuples == 0x0) // NULL pointer or empty string
+				return 0;
+
+			return Convert.ToInt32(new string(tuples), CultureInfo.InvariantCulture);
+		}
+
+		// consume the results of conn up to the pipeline sync and leave pipeline mode,
+		// resultsConsumed is true if the NULL result of the current statement has been consumed already
+		internal static void FinishPipeline(IntPtr conn, bool resultsConsumed)
+		{
+			// two NULL results in a row: there is nothing left to consume (e.g., broken connection)
+			int nulls = resultsConsumed ? 1 : 0;
+
+			while (nulls < 2)
+			{
+				IntPtr res = PqsqlWrapper.PQgetResult(conn);
+
+				if (res == IntPtr.Zero)
+				{
+					nulls++;
+					continue;
+				}
+
+				nulls = 0;
+				ExecStatusType s = PqsqlWrapper.PQresultStatus(res);
+				PqsqlWrapper.PQclear(res);
+
+				if (s == ExecStatusType.PGRES_PIPELINE_SYNC)
+					break;
+			}
+
+			PqsqlWrapper.PQexitPipelineMode(conn);
+		}
 	}
 }
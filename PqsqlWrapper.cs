@@ -47,7 +47,10 @@ namespace Pqsql
 		PGRES_NONFATAL_ERROR,	 /* notice or warning message */
 		PGRES_FATAL_ERROR,		 /* query failed */
 		PGRES_COPY_BOTH,			 /* Copy In/Out data transfer in progress */
-		PGRES_SINGLE_TUPLE		 /* single tuple from larger resultset */
+		PGRES_SINGLE_TUPLE,		 /* single tuple from larger resultset */
+		PGRES_PIPELINE_SYNC,	 /* pipeline synchronization point */
+		PGRES_PIPELINE_ABORTED, /* Command didn't run because of an abort earlier in a pipeline */
+		PGRES_TUPLES_CHUNK		 /* chunk of tuples from larger resultset */
 	};
 
 	// see enum PGTransactionStatusType in libpq-fe.h
@@ -633,6 +636,10 @@ namespace Pqsql
 			public static extern int PQsetSingleRowMode(IntPtr conn);
 			// int PQsetSingleRowMode(PGconn *conn);
 
+			[DllImport("libpq")]
+			public static extern int PQsetChunkedRowsMode(IntPtr conn, int chunkSize);
+			// int PQsetChunkedRowsMode(PGconn *conn, int chunkSize);
+
 			[DllImport("libpq")]
 			public static extern int PQclientEncoding(IntPtr conn);
 			// int PQclientEncoding(const PGconn *conn);
@@ -733,6 +740,14 @@ namespace Pqsql
 			public static extern unsafe int PQsendQueryParams(IntPtr conn, byte* command, int nParams, IntPtr paramTypes, IntPtr paramValues, IntPtr paramLengths, IntPtr paramFormats, int resultFormat);
 			// int PQsendQueryParams(PGconn *conn, const char *command, int nParams, const Oid *paramTypes, const char * const *paramValues, const int *paramLengths, const int *paramFormats, int resultFormat);
 
+			[DllImport("libpq")]
+			public static extern unsafe int PQsendPrepare(IntPtr conn, byte* stmtName, byte* query, int nParams, IntPtr paramTypes);
+			// int PQsendPrepare(PGconn *conn, const char *stmtName, const char *query, int nParams, const Oid *paramTypes);
+
+			[DllImport("libpq")]
+			public static extern unsafe int PQsendQueryPrepared(IntPtr conn, byte* stmtName, int nParams, IntPtr paramValues, IntPtr paramLengths, IntPtr paramFormats, int resultFormat);
+			// int PQsendQueryPrepared(PGconn *conn, const char *stmtName, int nParams, const char * const *paramValues, const int *paramLengths, const int *paramFormats, int resultFormat);
+
 			[DllImport("libpq")]
 			public static extern IntPtr PQgetResult(IntPtr conn);
 			// PGresult *PQgetResult(PGconn *conn)
@@ -745,6 +760,42 @@ namespace Pqsql
 			public static extern int PQisBusy(IntPtr conn);
 			// int PQisBusy(PGconn *conn);
 
+			[DllImport("libpq")]
+			public static extern int PQsetnonblocking(IntPtr conn, int arg);
+			// int PQsetnonblocking(PGconn *conn, int arg);
+
+			[DllImport("libpq")]
+			public static extern int PQisnonblocking(IntPtr conn);
+			// int PQisnonblocking(const PGconn *conn);
+
+			[DllImport("libpq")]
+			public static extern int PQflush(IntPtr conn);
+			// int PQflush(PGconn *conn);
+
+			#endregion
+
+			//
+			// http://www.postgresql.org/docs/current/static/libpq-pipeline-mode.html
+			//
+
+			#region pipeline mode
+
+			[DllImport("libpq")]
+			public static extern int PQenterPipelineMode(IntPtr conn);
+			// int PQenterPipelineMode(PGconn *conn);
+
+			[DllImport("libpq")]
+			public static extern int PQexitPipelineMode(IntPtr conn);
+			// int PQexitPipelineMode(PGconn *conn);
+
+			[DllImport("libpq")]
+			public static extern int PQpipelineSync(IntPtr conn);
+			// int PQpipelineSync(PGconn *conn);
+
+			[DllImport("libpq")]
+			public static extern int PQsendFlushRequest(IntPtr conn);
+			// int PQsendFlushRequest(PGconn *conn);
+
 			#endregion
 
 			#region result cleanup
@@ -769,6 +820,10 @@ namespace Pqsql
 			public static extern unsafe sbyte* PQcmdTuples(IntPtr res);
 			// char* PQcmdTuples(PGresult* res);
 
+			[DllImport("libpq")]
+			public static extern unsafe sbyte* PQcmdStatus(IntPtr res);
+			// char* PQcmdStatus(PGresult* res);
+
 			#endregion
 
 			#region field type and size information
@@ -829,6 +884,10 @@ namespace Pqsql
 			public static extern unsafe sbyte* PQresultErrorField(IntPtr res, int fieldcode);
 			// char *PQresultErrorField(const PGresult *res, int fieldcode);
 
+			[DllImport("libpq")]
+			public static extern unsafe sbyte* PQresultErrorMessage(IntPtr res);
+			// char *PQresultErrorMessage(const PGresult *res);
+
 			#endregion
 
 			//
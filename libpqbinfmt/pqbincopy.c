@@ -11,19 +11,27 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #define DLL_EXPORT
 #include "pqbincopy.h"
 #include "pqbinfmt.h"
+#include "pgadt/pg_type.h"
 
 /* COPY header signature */
 static const char BinarySignature[11] = "PGCOPY\n\377\r\n\0";
 /* NULL value stored in column length */
 static const char NullValue[4] = "\377\377\377\377";
+/* file trailer: 16-bit word containing -1 */
+static const char Trailer[2] = "\377\377";
 
 
+/*
+ * create COPY FROM buffer with bufsiz bytes (0 picks PQBUFSIZ),
+ * bufsiz is clamped to [PQMINBUFSIZ, PQMAXBUFSIZ]
+ */
 DECLSPEC pqcopy_buffer *
-pqcb_create(PGconn *conn, int num_cols)
+pqcb_create(PGconn *conn, int num_cols, size_t bufsiz)
 {
 	pqcopy_buffer *buf;
 
@@ -34,11 +42,28 @@ pqcb_create(PGconn *conn, int num_cols)
 		return NULL;
 	}
 
+	if (bufsiz == 0)
+		bufsiz = PQBUFSIZ;
+	else if (bufsiz < PQMINBUFSIZ)
+		bufsiz = PQMINBUFSIZ;
+	else if (bufsiz > PQMAXBUFSIZ)
+		bufsiz = PQMAXBUFSIZ;
+
 	buf = (pqcopy_buffer *) malloc(sizeof(pqcopy_buffer));
 
 	if (buf)
 	{
+		buf->buffer = (char *) malloc(bufsiz);
+		if (buf->buffer == NULL)
+		{
+			free(buf);
+			return NULL;
+		}
+
 		buf->conn = conn;
+		buf->bufsiz = bufsiz;
+		/* values filling more than half of the buffer are sent without staging */
+		buf->direct_len = bufsiz / 2;
 		pqcb_reset(buf, num_cols);
 	}
 
@@ -51,6 +76,7 @@ pqcb_free(pqcopy_buffer *p)
 {
 	if (p)
 	{
+		free(p->buffer);
 		free(p);
 	}
 }
@@ -88,11 +114,10 @@ static int
 pqcb_flush_buf(pqcopy_buffer *p, int force)
 {
 	int ret = 1;
-	size_t buf_len = p->pos + 1 >= PQBUFSIZ ? PQBUFSIZ : p->pos + 1;
 
-	if (force || buf_len == PQBUFSIZ)
+	if (p->pos > 0 && (force || p->pos == p->bufsiz))
 	{
-		ret = PQputCopyData(p->conn, p->buffer, buf_len);
+		ret = PQputCopyData(p->conn, p->buffer, (int) p->pos);
 
 		if (ret == 1)
 		{
@@ -104,18 +129,39 @@ pqcb_flush_buf(pqcopy_buffer *p, int force)
 }
 
 
+/* send len bytes starting from v without copying to p->buffer,
+ * flushes p->buffer first to keep the order of the COPY data
+ */
+static int
+pqcb_put_direct(pqcopy_buffer *p, const char* v, uint32_t len)
+{
+	int ret = pqcb_flush_buf(p, 1);
+
+	while (ret == 1 && len > 0)
+	{
+		int n = len > INT_MAX ? INT_MAX : (int) len;
+
+		ret = PQputCopyData(p->conn, v, n);
+		v += n;
+		len -= n;
+	}
+
+	return ret;
+}
+
+
 /* add len bytes starting from v to p->buffer.
  * flushes buffer if p->buffer is getting full during copying
  */
 static int
-pqcb_put_buf(pqcopy_buffer *p, char* v, uint32_t len)
+pqcb_put_buf(pqcopy_buffer *p, const char* v, uint32_t len)
 {
-	int remainder = len;
+	size_t remainder = len;
 	int ret;
 
 	do
 	{
-		int free = PQBUFSIZ - p->pos;
+		size_t free = p->bufsiz - p->pos;
 
 		if (free >= remainder)
 		{
@@ -142,14 +188,37 @@ pqcb_put_buf(pqcopy_buffer *p, char* v, uint32_t len)
 }
 
 
+/* add field length and len bytes of val to buffer, large values are sent directly */
+static int
+pqcb_put_value(pqcopy_buffer *p, const char* val, uint32_t len)
+{
+	int ret;
+	int32_t col_len = BYTESWAP4(len);
+
+	/* add field length to buffer / flush */
+	ret = pqcb_put_buf(p, (const char*) &col_len, sizeof(col_len));
+	if (ret != 1) return ret;
+
+	/* potentially add field value to buffer / flush */
+	if (len >= p->direct_len)
+	{
+		ret = pqcb_put_direct(p, val, len);
+	}
+	else if (len > 0)
+	{
+		ret = pqcb_put_buf(p, val, len);
+	}
+
+	return ret;
+}
+
+
 /* add val to pqcopy_buffer, potentially flushing */
 DECLSPEC int
 pqcb_put_col(pqcopy_buffer *p, const char* val, uint32_t len)
 {
 	int ret;
-	char *v;
 	int16_t tuple_len;
-	int32_t col_len;
 
 	BAILWITHVALUEIFNULL(p, -1);
 
@@ -167,10 +236,9 @@ pqcb_put_col(pqcopy_buffer *p, const char* val, uint32_t len)
 	if (p->pos_cols == -1 || p->pos_cols >= p->num_cols)
 	{
 		tuple_len = BYTESWAP2(p->num_cols);
-		v = (char*) &tuple_len;
 
 		/* add tuple length to buffer / flush */
-		ret = pqcb_put_buf(p, v, sizeof(tuple_len));
+		ret = pqcb_put_buf(p, (const char*) &tuple_len, sizeof(tuple_len));
 		if (ret != 1) return ret;
 
 		p->pos_cols = 0;
@@ -184,29 +252,182 @@ pqcb_put_col(pqcopy_buffer *p, const char* val, uint32_t len)
 
 	if (val == NULL && len > 0)
 	{
-		len = 0; /* NULL value, ignore field value */
-		v = (char*) NullValue;
+		/* NULL value, ignore field value */
+		ret = pqcb_put_buf(p, NullValue, sizeof(NullValue));
 	}
 	else
 	{
 		/* len >= 0, we might want to copy empty strings or bytea (len == 0) */
-		col_len = BYTESWAP4(len);
-		v = (char*) &col_len;
+		ret = pqcb_put_value(p, val, len);
 	}
 
-	/* add field length to buffer / flush */
-	ret = pqcb_put_buf(p, v, sizeof(col_len));
 	if (ret != 1) return ret;
 
-	/* potentially add field value to buffer / flush */
-	if (len > 0)
+	p->pos_cols++;
+
+	return ret;
+}
+
+
+/* length of the binary representation of fixed-length type oid,
+ * 0 for variable-length types sent as raw bytes, and -1 for unsupported types
+ */
+int
+pqcb_get_typlen(uint32_t oid)
+{
+	switch (oid)
 	{
-		v = (char*) val;
-		ret = pqcb_put_buf(p, v, len);
-		if (ret != 1) return ret;
+	case BOOLOID:
+	case CHAROID:
+		return 1;
+	case INT2OID:
+		return 2;
+	case INT4OID:
+	case OIDOID:
+	case FLOAT4OID:
+	case DATEOID:
+		return 4;
+	case INT8OID:
+	case FLOAT8OID:
+	case CASHOID:
+	case TIMEOID:
+	case TIMESTAMPOID:
+	case TIMESTAMPTZOID:
+		return 8;
+	case BYTEAOID:
+	case NAMEOID:
+	case TEXTOID:
+	case BPCHAROID:
+	case VARCHAROID:
+		return 0;
+	default:
+		return -1;
 	}
+}
 
-	p->pos_cols++;
+
+/* add nrows complete tuples with ncols columns described by cols to pqcopy_buffer,
+ * ncols must match the number of columns and the last tuple must be complete.
+ * returns 1 on success, 0 or -1 on failure like pqcb_put_col()
+ */
+DECLSPEC int
+pqcb_put_rows(pqcopy_buffer *p, const pqcopy_column *cols, int ncols, int nrows)
+{
+	int ret = 1;
+	int i;
+	int j;
+	int16_t tuple_len;
+	int *typlen;
+	const char **vals;
+
+	BAILWITHVALUEIFNULL(p, -1);
+	BAILWITHVALUEIFNULL(cols, -1);
+
+	/* invalid pqcopy_buffer, wrong number of columns, or incomplete tuple? */
+	if (p->pos_cols == -2 || ncols != p->num_cols || nrows < 0 ||
+		(p->pos_cols != -1 && p->pos_cols < p->num_cols))
+	{
+		return -1;
+	}
+
+	if (nrows == 0)
+		return 1;
+
+	typlen = (int *) malloc(ncols * sizeof(int));
+	vals = (const char **) malloc(ncols * sizeof(const char *));
+
+	if (typlen == NULL || vals == NULL)
+	{
+		ret = -1;
+		goto done;
+	}
+
+	for (j = 0; j < ncols; j++)
+	{
+		typlen[j] = pqcb_get_typlen(cols[j].oid);
+		vals[j] = (const char *) cols[j].values;
+
+		if (typlen[j] < 0 || (typlen[j] == 0 && cols[j].lens == NULL) || (typlen[j] > 0 && vals[j] == NULL))
+		{
+			ret = -1;
+			goto done;
+		}
+	}
+
+	tuple_len = BYTESWAP2(p->num_cols);
+
+	for (i = 0; i < nrows && ret == 1; i++)
+	{
+		ret = pqcb_put_buf(p, (const char*) &tuple_len, sizeof(tuple_len));
+
+		for (j = 0; j < ncols && ret == 1; j++)
+		{
+			const pqcopy_column *c = &cols[j];
+			int len = typlen[j];
+			int isnull = c->nullmap && (c->nullmap[i >> 3] & (1 << (i & 7)));
+
+			if (len == 0)
+			{
+				/* variable-length value, NULL values don't use any bytes in vals[j] */
+				if (isnull || c->lens[i] < 0)
+				{
+					ret = pqcb_put_buf(p, NullValue, sizeof(NullValue));
+				}
+				else
+				{
+					ret = pqcb_put_value(p, vals[j], c->lens[i]);
+					vals[j] += c->lens[i];
+				}
+			}
+			else if (isnull)
+			{
+				ret = pqcb_put_buf(p, NullValue, sizeof(NullValue));
+			}
+			else
+			{
+				/* fixed-length value: field length followed by value in network order */
+				char field[sizeof(int32_t) + sizeof(uint64_t)];
+				uint32_t l = BYTESWAP4((uint32_t) len);
+
+				memcpy(field, &l, sizeof(l));
+
+				switch (len)
+				{
+				case 1:
+					field[4] = ((const char *) c->values)[i];
+					break;
+				case 2:
+				{
+					uint16_t v = BYTESWAP2(((const uint16_t *) c->values)[i]);
+					memcpy(&field[4], &v, sizeof(v));
+					break;
+				}
+				case 4:
+				{
+					uint32_t v = BYTESWAP4(((const uint32_t *) c->values)[i]);
+					memcpy(&field[4], &v, sizeof(v));
+					break;
+				}
+				case 8:
+				{
+					uint64_t v = BYTESWAP8(((const uint64_t *) c->values)[i]);
+					memcpy(&field[4], &v, sizeof(v));
+					break;
+				}
+				}
+
+				ret = pqcb_put_buf(p, field, sizeof(l) + len);
+			}
+		}
+	}
+
+	/* last tuple is complete */
+	if (ret == 1)
+		p->pos_cols = p->num_cols;
+
+done:
+	free(typlen);
+	free(vals);
 
 	return ret;
 }
@@ -216,6 +437,8 @@ pqcb_put_col(pqcopy_buffer *p, const char* val, uint32_t len)
 DECLSPEC int
 pqcb_put_end(pqcopy_buffer *p)
 {
+	int ret;
+
 	BAILWITHVALUEIFNULL(p, -1);
 
 	/* invalid pqcopy_buffer? */
@@ -224,14 +447,14 @@ pqcb_put_end(pqcopy_buffer *p)
 		return -1;
 	}
 
-	if (p->pos > 0)
-	{
-		/* force flush remaining buffer */
-		int ret = pqcb_flush_buf(p, 1);
-		if (ret != 1)	return ret;
-		p->pos = 0;
-		p->pos_cols = -2; /* marks pqcopy_buffer as invalid */
-	}
+	/* add file trailer and force flush remaining buffer */
+	ret = pqcb_put_buf(p, Trailer, sizeof(Trailer));
+	if (ret != 1) return ret;
+
+	ret = pqcb_flush_buf(p, 1);
+	if (ret != 1) return ret;
+
+	p->pos_cols = -2; /* marks pqcopy_buffer as invalid */
 
 	/* send COPY trailer */
 	return PQputCopyEnd(p->conn, NULL);
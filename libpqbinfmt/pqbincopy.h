@@ -20,10 +20,13 @@
 extern "C" {
 #endif
 
+/* default, minimal, and maximal size of the COPY FROM buffer */
 #define PQBUFSIZ 8192
+#define PQMINBUFSIZ 1024
+#define PQMAXBUFSIZ (16 * 1024 * 1024)
 
 /*
- * data structure encapsulating 8k COPY FROM buffer
+ * data structure encapsulating the COPY FROM buffer
  */
 typedef struct pqcopy_buffer
 {
@@ -31,17 +34,40 @@ typedef struct pqcopy_buffer
 	uint16_t num_cols;     /* number of columns for each tuple (fixed) */
 	int16_t pos_cols;      /* column number in current tuple */
 	size_t pos;            /* position in buffer */
-	char buffer[PQBUFSIZ]; /* stores COPY header, tuple / column length and data payload */
+	size_t bufsiz;         /* size of buffer */
+	size_t direct_len;     /* field values of at least direct_len bytes bypass buffer */
+	char *buffer;          /* stores COPY header, tuple / column length and data payload */
 } pqcopy_buffer;
 
+/*
+ * column descriptor for pqcb_put_rows()
+ *
+ * fixed-length types store their values in host byte order in the
+ * contiguous array values, one item per row.  Variable-length types (bytea
+ * and character types) store the raw bytes of all non-NULL rows back to back
+ * in values and the byte length of each row in lens, lens[i] < 0 denotes NULL
+ * (values may be NULL if no row has a positive length).
+ * Bit i of nullmap (LSB first) is set iff row i is NULL, nullmap may be NULL.
+ */
+typedef struct pqcopy_column
+{
+	uint32_t oid;           /* type oid of the destination column */
+	const void *values;     /* column values */
+	const int32_t *lens;    /* row lengths of variable-length values, NULL for fixed-length types */
+	const uint8_t *nullmap; /* NULL bitmap */
+} pqcopy_column;
 
-extern DECLSPEC pqcopy_buffer *pqcb_create(PGconn *conn, int num_cols);
+
+extern DECLSPEC pqcopy_buffer *pqcb_create(PGconn *conn, int num_cols, size_t bufsiz);
 extern DECLSPEC void pqcb_free(pqcopy_buffer *p);
 extern DECLSPEC void pqcb_reset(pqcopy_buffer *p, int num_cols);
 
 extern DECLSPEC int pqcb_put_col(pqcopy_buffer *buf, const char* val, uint32_t len);
+extern DECLSPEC int pqcb_put_rows(pqcopy_buffer *buf, const pqcopy_column *cols, int ncols, int nrows);
 extern DECLSPEC int pqcb_put_end(pqcopy_buffer *buf);
 
+extern int pqcb_get_typlen(uint32_t oid);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -1093,6 +1093,275 @@ pqbf_set_numeric(PQExpBuffer s, double d)
 }
 
 
+/*
+ * oid 1700: numeric <-> 96-bit decimal
+ *
+ * converts the NBASE-10000 digit array of the numeric binary format
+ * directly to and from the (lo, mid, hi, scale, sign) layout of .NET's
+ * System.Decimal, without numeric_recv() / numeric_out() and string parsing
+ */
+
+#define PQBF_NUMERIC_POS	0x0000
+#define PQBF_NUMERIC_NEG	0x4000
+#define PQBF_NUMERIC_NBASE	10000
+#define PQBF_NUMERIC_DEC_DIGITS	4
+#define PQBF_DECIMAL_MAX_SCALE	28
+#define PQBF_DECIMAL_MAX_DIGITS	8 /* ceil((29 decimal digits + 3 alignment digits) / 4) */
+
+/* 96-bit unsigned integer m = m[2] * 2^64 + m[1] * 2^32 + m[0] */
+
+/* m = m * mul + add, returns 0 on overflow (m is left untouched) */
+static int
+pqbf_u96_muladd(uint32_t m[3], uint32_t mul, uint32_t add)
+{
+	uint64_t t0 = (uint64_t) m[0] * mul + add;
+	uint64_t t1 = (uint64_t) m[1] * mul + (t0 >> 32);
+	uint64_t t2 = (uint64_t) m[2] * mul + (t1 >> 32);
+
+	if (t2 > UINT32_MAX)
+		return 0;
+
+	m[0] = (uint32_t) t0;
+	m[1] = (uint32_t) t1;
+	m[2] = (uint32_t) t2;
+
+	return 1;
+}
+
+/* m = m / div, returns m % div */
+static uint32_t
+pqbf_u96_divrem(uint32_t m[3], uint32_t div)
+{
+	uint64_t r = 0;
+	int i;
+
+	for (i = 2; i >= 0; i--)
+	{
+		uint64_t t = (r << 32) | m[i];
+		m[i] = (uint32_t) (t / div);
+		r = t % div;
+	}
+
+	return (uint32_t) r;
+}
+
+/* m = m / 10 rounded half up, used when rounding m + 1 overflows */
+static void
+pqbf_u96_round_overflow(uint32_t m[3], int32_t *scale)
+{
+	/* m is 2^96 - 1 here, so (m + 1) % 10 == m % 10 + 1 */
+	uint32_t r = pqbf_u96_divrem(m, 10);
+
+	if (r + 1 >= 5)
+		pqbf_u96_muladd(m, 1, 1);
+
+	(*scale)--;
+}
+
+/* get decimal digit of numeric digit array p at 10^e */
+static uint32_t
+pqbf_numeric_digit(const uint16_t *p, int32_t ndigits, int32_t weight, int32_t e)
+{
+	int32_t ge = e >= 0 ? e / PQBF_NUMERIC_DEC_DIGITS : -((-e + PQBF_NUMERIC_DEC_DIGITS - 1) / PQBF_NUMERIC_DEC_DIGITS);
+	int32_t di = weight - ge;
+	int32_t pos = e - ge * PQBF_NUMERIC_DEC_DIGITS;
+	uint32_t d;
+
+	if (di < 0 || di >= ndigits)
+		return 0;
+
+	d = (uint16_t) BYTESWAP2(p[di]);
+
+	while (pos-- > 0)
+		d /= 10;
+
+	return d % 10;
+}
+
+/*
+ * decode numeric binary format to 96-bit decimal
+ *
+ * returns 1 on success, 0 if ptr is NaN or +/-Infinity, -1 if the integral
+ * part of ptr does not fit in 96 bits or ptr is malformed.
+ * fractional digits beyond the representable precision are rounded half
+ * away from zero, just like numeric's round()
+ */
+DECLSPEC int
+pqbf_get_decimal(const char *ptr, uint32_t *lo, uint32_t *mid, uint32_t *hi, int32_t *scale, int32_t *sign)
+{
+	const uint16_t *p;
+	int32_t ndigits, weight, dscale, i, e, s;
+	uint16_t nsign;
+	uint32_t m[3] = { 0, 0, 0 };
+	uint32_t round;
+
+	BAILWITHVALUEIFNULL(ptr, -1);
+	BAILWITHVALUEIFNULL(lo, -1);
+	BAILWITHVALUEIFNULL(mid, -1);
+	BAILWITHVALUEIFNULL(hi, -1);
+	BAILWITHVALUEIFNULL(scale, -1);
+	BAILWITHVALUEIFNULL(sign, -1);
+
+	p = (const uint16_t *) ptr;
+
+	/* header: ndigits, weight, sign, dscale */
+	ndigits = (uint16_t) BYTESWAP2(p[0]);
+	weight = (int16_t) BYTESWAP2(p[1]);
+	nsign = (uint16_t) BYTESWAP2(p[2]);
+	dscale = (uint16_t) BYTESWAP2(p[3]);
+	p += 4;
+
+	if (nsign != PQBF_NUMERIC_POS && nsign != PQBF_NUMERIC_NEG)
+		return 0; /* NaN, Infinity, -Infinity */
+
+	for (i = 0; i < ndigits; i++)
+	{
+		if ((uint16_t) BYTESWAP2(p[i]) >= PQBF_NUMERIC_NBASE)
+			return -1;
+	}
+
+	s = dscale > PQBF_DECIMAL_MAX_SCALE ? PQBF_DECIMAL_MAX_SCALE : dscale;
+
+	/*
+	 * accumulate decimal digits from 10^e down to 10^-s, whole NBASE digits
+	 * are multiplied in at once as long as the mantissa has room for them
+	 */
+	for (e = (weight + 1) * PQBF_NUMERIC_DEC_DIGITS - 1; e >= -s; e--)
+	{
+		uint32_t d;
+
+		if (((e % PQBF_NUMERIC_DEC_DIGITS) + PQBF_NUMERIC_DEC_DIGITS) % PQBF_NUMERIC_DEC_DIGITS == PQBF_NUMERIC_DEC_DIGITS - 1
+			&& e - (PQBF_NUMERIC_DEC_DIGITS - 1) >= -s)
+		{
+			/* e is the leading decimal digit of NBASE digit di */
+			int32_t di = weight - (e - (PQBF_NUMERIC_DEC_DIGITS - 1)) / PQBF_NUMERIC_DEC_DIGITS;
+
+			d = di >= 0 && di < ndigits ? (uint16_t) BYTESWAP2(p[di]) : 0;
+
+			if (pqbf_u96_muladd(m, PQBF_NUMERIC_NBASE, d))
+			{
+				e -= PQBF_NUMERIC_DEC_DIGITS - 1;
+				continue;
+			}
+		}
+
+		d = pqbf_numeric_digit(p, ndigits, weight, e);
+
+		if (!pqbf_u96_muladd(m, 10, d))
+		{
+			if (e >= 0)
+				return -1; /* integral part does not fit in 96 bits */
+
+			/* no room for more fractional digits */
+			s = -e - 1;
+			break;
+		}
+	}
+
+	/* round half away from zero using the first dropped digit */
+	round = pqbf_numeric_digit(p, ndigits, weight, -s - 1);
+
+	if (round >= 5 && !pqbf_u96_muladd(m, 1, 1))
+	{
+		if (s == 0)
+			return -1;
+
+		pqbf_u96_round_overflow(m, &s);
+	}
+
+	*lo = m[0];
+	*mid = m[1];
+	*hi = m[2];
+	*scale = s;
+	*sign = nsign == PQBF_NUMERIC_NEG && (m[0] | m[1] | m[2]) != 0;
+
+	return 1;
+}
+
+/* encode 96-bit decimal as numeric binary format, returns encoded length */
+inline size_t
+pqbf_encode_decimal(PQExpBuffer s, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign)
+{
+	static const uint32_t pow10[PQBF_NUMERIC_DEC_DIGITS] = { 1, 10, 100, 1000 };
+	uint32_t m[3];
+	uint16_t digits[PQBF_DECIMAL_MAX_DIGITS]; /* NBASE digits, least significant first */
+	uint16_t buf[4 + PQBF_DECIMAL_MAX_DIGITS];
+	int32_t ndigits = 0, first = 0, weight, r, i;
+	size_t len;
+
+	if (scale < 0)
+		scale = 0;
+	else if (scale > PQBF_DECIMAL_MAX_SCALE)
+		scale = PQBF_DECIMAL_MAX_SCALE;
+
+	m[0] = lo;
+	m[1] = mid;
+	m[2] = hi;
+
+	/* align the fractional digits to NBASE digits */
+	r = scale % PQBF_NUMERIC_DEC_DIGITS;
+	if (r > 0)
+	{
+		digits[ndigits++] = (uint16_t) (pqbf_u96_divrem(m, pow10[r]) * pow10[PQBF_NUMERIC_DEC_DIGITS - r]);
+	}
+
+	while ((m[0] | m[1] | m[2]) != 0)
+	{
+		digits[ndigits++] = (uint16_t) pqbf_u96_divrem(m, PQBF_NUMERIC_NBASE);
+	}
+
+	/* skip trailing zero digits, they are implied by dscale */
+	while (first < ndigits && digits[first] == 0)
+		first++;
+
+	weight = ndigits - (scale + PQBF_NUMERIC_DEC_DIGITS - 1) / PQBF_NUMERIC_DEC_DIGITS - 1;
+
+	if (first == ndigits)
+	{
+		/* zero */
+		ndigits = 0;
+		first = 0;
+		weight = 0;
+		sign = 0;
+	}
+
+	buf[0] = BYTESWAP2((uint16_t) (ndigits - first));
+	buf[1] = BYTESWAP2((uint16_t) weight);
+	buf[2] = BYTESWAP2((uint16_t) (sign ? PQBF_NUMERIC_NEG : PQBF_NUMERIC_POS));
+	buf[3] = BYTESWAP2((uint16_t) scale);
+
+	/* most significant digit first */
+	for (i = ndigits - 1; i >= first; i--)
+	{
+		buf[4 + ndigits - 1 - i] = BYTESWAP2(digits[i]);
+	}
+
+	len = (4 + ndigits - first) * sizeof(uint16_t);
+	appendBinaryPQExpBuffer(s, (const char *) buf, len);
+
+	return len;
+}
+
+DECLSPEC void
+pqbf_set_decimal(PQExpBuffer s, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign)
+{
+	BAILIFNULL(s);
+	pqbf_encode_decimal(s, lo, mid, hi, scale, sign);
+}
+
+DECLSPEC void
+pqbf_add_decimal(pqparam_buffer *pb, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign)
+{
+	size_t len;
+
+	BAILIFNULL(pb);
+
+	len = pqbf_encode_decimal(pb->payload, lo, mid, hi, scale, sign);
+
+	pqpb_add(pb, NUMERICOID, len);
+}
+
+
 
 /*
  * oid 2950: uuid
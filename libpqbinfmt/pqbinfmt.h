@@ -11,6 +11,7 @@
 #define __PQ_BINFMT_H
 
 #include <stdint.h>
+#include <libpq-fe.h>
 #include "pqparam_buffer.h"
 
 #ifndef _WIN32
@@ -88,6 +89,11 @@ extern DECLSPEC double pqbf_get_numeric(const char *ptr, int32_t typmod);
 extern DECLSPEC void pqbf_set_numeric(PQExpBuffer s, double d);
 extern DECLSPEC void pqbf_add_numeric(pqparam_buffer *pb, double d);
 
+size_t pqbf_encode_decimal(PQExpBuffer s, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign);
+extern DECLSPEC int pqbf_get_decimal(const char *ptr, uint32_t *lo, uint32_t *mid, uint32_t *hi, int32_t *scale, int32_t *sign);
+extern DECLSPEC void pqbf_set_decimal(PQExpBuffer s, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign);
+extern DECLSPEC void pqbf_add_decimal(pqparam_buffer *pb, uint32_t lo, uint32_t mid, uint32_t hi, int32_t scale, int32_t sign);
+
 void pqbf_encode_timestamp(PQExpBuffer s, time_t sec, int usec);
 extern DECLSPEC void pqbf_get_timestamp(const char *p, time_t *sec, int *usec);
 extern DECLSPEC void pqbf_set_timestamp(PQExpBuffer s, time_t sec, int usec);
@@ -117,12 +123,28 @@ extern DECLSPEC void pqbf_add_date(pqparam_buffer *pb, int32_t year, int32_t mon
 void pqbf_encode_array(PQExpBuffer s, int32_t ndim, int32_t flags, uint32_t oid, int dim[MAXDIM], int lbound[MAXDIM]);
 extern DECLSPEC const char * pqbf_get_array(const char* p, int32_t* ndim, int32_t* flags, uint32_t* oid,	int* dim[MAXDIM],	int* lbound[MAXDIM]);
 extern DECLSPEC const char * pqbf_get_array_value(const char* p, int32_t* itemlen);
+extern DECLSPEC int32_t pqbf_get_array_values(const char *p, int32_t n, int32_t itemlen, void *values);
 extern DECLSPEC void pqbf_set_array(PQExpBuffer s, int32_t ndim, int32_t flags, uint32_t oid, int dim[MAXDIM],	int lbound[MAXDIM]);
 extern DECLSPEC void pqbf_add_array(pqparam_buffer *pb, PQExpBuffer a, uint32_t oid);
+extern DECLSPEC void pqbf_add_int2_array(pqparam_buffer *pb, const int16_t *values, int32_t n, const uint8_t *nullmap);
+extern DECLSPEC void pqbf_add_int4_array(pqparam_buffer *pb, const int32_t *values, int32_t n, const uint8_t *nullmap);
+extern DECLSPEC void pqbf_add_int8_array(pqparam_buffer *pb, const int64_t *values, int32_t n, const uint8_t *nullmap);
+extern DECLSPEC void pqbf_add_float4_array(pqparam_buffer *pb, const float *values, int32_t n, const uint8_t *nullmap);
+extern DECLSPEC void pqbf_add_float8_array(pqparam_buffer *pb, const double *values, int32_t n, const uint8_t *nullmap);
+extern DECLSPEC void pqbf_add_oid_array(pqparam_buffer *pb, const uint32_t *values, int32_t n, const uint8_t *nullmap);
 extern DECLSPEC void pqbf_set_array_itemlength(PQExpBuffer a, int32_t itemlen);
 extern DECLSPEC void pqbf_update_array_itemlength(PQExpBuffer a, ptrdiff_t offset, int32_t itemlen);
 extern DECLSPEC void pqbf_set_array_value(PQExpBuffer a, const char* p, int32_t itemlen);
 
+extern DECLSPEC int pqbf_decode_column_bool(const PGresult *res, int col, int row, int nrows, uint8_t *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_int2(const PGresult *res, int col, int row, int nrows, int16_t *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_int4(const PGresult *res, int col, int row, int nrows, int32_t *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_int8(const PGresult *res, int col, int row, int nrows, int64_t *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_float4(const PGresult *res, int col, int row, int nrows, float *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_float8(const PGresult *res, int col, int row, int nrows, double *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_timestamp(const PGresult *res, int col, int row, int nrows, int64_t *values, uint8_t *nullmap);
+extern DECLSPEC int pqbf_decode_column_date(const PGresult *res, int col, int row, int nrows, int32_t *values, uint8_t *nullmap);
+
 #ifdef  __cplusplus
 }
 #endif
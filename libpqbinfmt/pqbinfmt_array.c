@@ -20,6 +20,21 @@
 #define DLL_EXPORT
 #include "pqbinfmt_config.h"
 #include "pqbinfmt.h"
+#include "pgadt/pg_type.h"
+
+/* array type oids, see src/include/catalog/pg_type.dat */
+#define INT2ARRAYOID	1005
+#define INT4ARRAYOID	1007
+#define INT8ARRAYOID	1016
+#define FLOAT4ARRAYOID	1021
+#define FLOAT8ARRAYOID	1022
+#define OIDARRAYOID		1028
+
+/* SSE2 is part of the x86-64 baseline, no runtime cpu detection needed */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PQBF_SSE2
+#include <emmintrin.h>
+#endif
 
 
 DECLSPEC const char *
@@ -75,6 +90,111 @@ pqbf_get_array_value(const char* p, int32_t* itemlen)
 }
 
 
+#ifdef PQBF_SSE2
+/*
+ * 4 byte items: a 16 byte load contains two (itemlen, value) pairs, so
+ * 32 input bytes are checked and byte-swapped into 16 output bytes
+ */
+static int32_t
+pqbf_get_array_values4_sse2(const char *p, int32_t n, uint32_t *values)
+{
+	const __m128i len = _mm_set1_epi32((int) BYTESWAP4((uint32_t) sizeof(uint32_t)));
+	int32_t i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *) p); /* len0 val0 len1 val1 */
+		__m128i b = _mm_loadu_si128((const __m128i *) (p + 16)); /* len2 val2 len3 val3 */
+		__m128i v;
+
+		/* itemlen words are in lanes 0 and 2 */
+		if ((_mm_movemask_epi8(_mm_cmpeq_epi32(a, len)) & 0x0F0F) != 0x0F0F
+			|| (_mm_movemask_epi8(_mm_cmpeq_epi32(b, len)) & 0x0F0F) != 0x0F0F)
+			return -1;
+
+		/* gather val0 val1 val2 val3 */
+		v = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		/* swap bytes of each 16 bit word, then swap the words of each 32 bit lane */
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+
+		_mm_storeu_si128((__m128i *) (values + i), v);
+		p += 32;
+	}
+
+	return i;
+}
+#endif /* PQBF_SSE2 */
+
+
+/*
+ * decode the n items of a one-dimensional array without NULL values, p
+ * points to the array data returned by pqbf_get_array(). Every item must
+ * have length itemlen (2, 4, or 8 bytes), the values are byte-swapped into
+ * the contiguous buffer values.
+ *
+ * returns n, or -1 if an item is NULL or has a different length
+ */
+DECLSPEC int32_t
+pqbf_get_array_values(const char *p, int32_t n, int32_t itemlen, void *values)
+{
+	const uint32_t len = BYTESWAP4((uint32_t) itemlen);
+	int32_t i = 0;
+
+	BAILWITHVALUEIFNULL(p, -1);
+	BAILWITHVALUEIFNULL(values, -1);
+
+	if (n < 0)
+		return -1;
+
+	switch (itemlen)
+	{
+	case 2:
+		for (; i < n; i++)
+		{
+			if (*((uint32_t *) p) != len)
+				return -1;
+			((uint16_t *) values)[i] = BYTESWAP2(*((uint16_t *) (p + sizeof(int32_t))));
+			p += sizeof(int32_t) + sizeof(uint16_t);
+		}
+		break;
+
+	case 4:
+#ifdef PQBF_SSE2
+		i = pqbf_get_array_values4_sse2(p, n, (uint32_t *) values);
+		if (i < 0)
+			return -1;
+		p += (size_t) i * (sizeof(int32_t) + sizeof(uint32_t));
+#endif /* PQBF_SSE2 */
+		for (; i < n; i++)
+		{
+			if (*((uint32_t *) p) != len)
+				return -1;
+			((uint32_t *) values)[i] = BYTESWAP4(*((uint32_t *) (p + sizeof(int32_t))));
+			p += sizeof(int32_t) + sizeof(uint32_t);
+		}
+		break;
+
+	case 8:
+		for (; i < n; i++)
+		{
+			if (*((uint32_t *) p) != len)
+				return -1;
+			((uint64_t *) values)[i] = BYTESWAP8(*((uint64_t *) (p + sizeof(int32_t))));
+			p += sizeof(int32_t) + sizeof(uint64_t);
+		}
+		break;
+
+	default:
+		return -1;
+	}
+
+	return n;
+}
+
+
 inline void
 pqbf_encode_array(PQExpBuffer s, int32_t ndim, int32_t flags, uint32_t oid,
 					int dim[MAXDIM], int lbound[MAXDIM])
@@ -149,6 +269,172 @@ pqbf_add_array(pqparam_buffer *pb, PQExpBuffer a, uint32_t oid)
 }
 
 
+#ifdef PQBF_SSE2
+/*
+ * 4 byte items: byte-swap four values and interleave them with their
+ * itemlen words, 16 input bytes produce 32 output bytes
+ */
+static int32_t
+pqbf_set_array_values4_sse2(char *p, int32_t n, const uint32_t *values)
+{
+	const __m128i len = _mm_set1_epi32((int) BYTESWAP4((uint32_t) sizeof(uint32_t)));
+	int32_t i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *) (values + i));
+
+		/* swap bytes of each 16 bit word, then swap the words of each 32 bit lane */
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+
+		_mm_storeu_si128((__m128i *) p, _mm_unpacklo_epi32(len, v)); /* len val0 len val1 */
+		_mm_storeu_si128((__m128i *) (p + 16), _mm_unpackhi_epi32(len, v)); /* len val2 len val3 */
+		p += 32;
+	}
+
+	return i;
+}
+#endif /* PQBF_SSE2 */
+
+
+/*
+ * encode n fixed-length items of values as one-dimensional array parameter
+ * directly into the payload of pb. If nullmap is not NULL, item i is NULL
+ * iff bit i of nullmap (LSB first) is set.
+ */
+static void
+pqbf_add_fixed_array(pqparam_buffer *pb, const void *values, int32_t n, int32_t itemlen,
+					const uint8_t *nullmap, uint32_t oid, uint32_t arrayoid)
+{
+	PQExpBuffer s;
+	size_t len;
+	int32_t flags = 0;
+	int32_t nnulls = 0;
+	int32_t i = 0;
+	int dim[MAXDIM] = { 0 };
+	int lbound[MAXDIM] = { 0 };
+	char *p;
+
+	BAILIFNULL(pb);
+
+	if (n < 0 || (values == NULL && n > 0))
+		return;
+
+	s = pb->payload;
+	len = s->len; /* save current length of payload */
+
+	if (nullmap)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (nullmap[i >> 3] & (1 << (i & 7)))
+				nnulls++;
+		}
+		flags = nnulls > 0;
+	}
+
+	/* reserve room for the headers, all itemlen words, and values */
+	if (enlargePQExpBuffer(s, 5 * sizeof(int32_t) + (size_t) n * sizeof(int32_t) + (size_t) (n - nnulls) * itemlen) == 0)
+		return;
+
+	/* 12 byte array header + 8 byte dimension header */
+	dim[0] = n;
+	lbound[0] = 1;
+	pqbf_encode_array(s, 1, flags, oid, dim, lbound);
+
+	p = s->data + s->len;
+	i = 0;
+
+#ifdef PQBF_SSE2
+	if (itemlen == sizeof(uint32_t) && !flags)
+	{
+		i = pqbf_set_array_values4_sse2(p, n, (const uint32_t *) values);
+		p += (size_t) i * (sizeof(int32_t) + sizeof(uint32_t));
+	}
+#endif /* PQBF_SSE2 */
+
+	for (; i < n; i++)
+	{
+		uint32_t l;
+
+		if (flags && (nullmap[i >> 3] & (1 << (i & 7))))
+		{
+			/* null values have itemlength -1 only */
+			l = BYTESWAP4((uint32_t) -1);
+			memcpy(p, &l, sizeof(l));
+			p += sizeof(l);
+			continue;
+		}
+
+		l = BYTESWAP4((uint32_t) itemlen);
+		memcpy(p, &l, sizeof(l));
+		p += sizeof(l);
+
+		switch (itemlen)
+		{
+		case 2:
+			*((uint16_t *) p) = BYTESWAP2(((const uint16_t *) values)[i]);
+			break;
+		case 4:
+			*((uint32_t *) p) = BYTESWAP4(((const uint32_t *) values)[i]);
+			break;
+		case 8:
+			*((uint64_t *) p) = BYTESWAP8(((const uint64_t *) values)[i]);
+			break;
+		}
+		p += itemlen;
+	}
+
+	s->len = p - s->data;
+	s->data[s->len] = '\0';
+
+	pqpb_add(pb, arrayoid, s->len - len);
+}
+
+
+DECLSPEC void
+pqbf_add_int2_array(pqparam_buffer *pb, const int16_t *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(int16_t), nullmap, INT2OID, INT2ARRAYOID);
+}
+
+
+DECLSPEC void
+pqbf_add_int4_array(pqparam_buffer *pb, const int32_t *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(int32_t), nullmap, INT4OID, INT4ARRAYOID);
+}
+
+
+DECLSPEC void
+pqbf_add_int8_array(pqparam_buffer *pb, const int64_t *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(int64_t), nullmap, INT8OID, INT8ARRAYOID);
+}
+
+
+DECLSPEC void
+pqbf_add_float4_array(pqparam_buffer *pb, const float *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(float), nullmap, FLOAT4OID, FLOAT4ARRAYOID);
+}
+
+
+DECLSPEC void
+pqbf_add_float8_array(pqparam_buffer *pb, const double *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(double), nullmap, FLOAT8OID, FLOAT8ARRAYOID);
+}
+
+
+DECLSPEC void
+pqbf_add_oid_array(pqparam_buffer *pb, const uint32_t *values, int32_t n, const uint8_t *nullmap)
+{
+	pqbf_add_fixed_array(pb, values, n, sizeof(uint32_t), nullmap, OIDOID, OIDARRAYOID);
+}
+
 DECLSPEC void
 pqbf_set_array_value(PQExpBuffer a, const char* p, int32_t itemlen)
 {
@@ -0,0 +1,169 @@
+/**
+ * @file pqbinfmt_column.c
+ * @brief decode a whole column of a binary PGresult into native arrays
+ * @copyright Copyright (c) 2015-2017, XIMES GmbH
+ * @see https://www.postgresql.org/docs/current/static/libpq-exec.html
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#define DLL_EXPORT
+#include "pqbinfmt_config.h"
+#include "pqbinfmt.h"
+
+
+/*
+ * decode nrows values of fixed-length column col starting at row into values.
+ *
+ * values must have room for nrows items of size len. If nullmap is not NULL,
+ * bit i of nullmap (LSB first) is set iff row + i is NULL, and nullmap must
+ * have room for (nrows + 7) / 8 bytes. NULL values are decoded as 0.
+ *
+ * returns the number of decoded rows (nrows is truncated to the number of
+ * available rows), or -1 if col is not a binary column with values of length len
+ */
+static int
+pqbf_decode_column(const PGresult *res, int col, int row, int nrows, int len, void *values, uint8_t *nullmap)
+{
+	int i;
+	int ntuples;
+
+	BAILWITHVALUEIFNULL(res, -1);
+	BAILWITHVALUEIFNULL(values, -1);
+
+	if (col < 0 || col >= PQnfields(res) || PQfformat(res, col) != 1)
+		return -1;
+
+	ntuples = PQntuples(res);
+
+	if (row < 0 || nrows < 0)
+		return -1;
+
+	if (row >= ntuples)
+		return 0;
+
+	if (nrows > ntuples - row)
+		nrows = ntuples - row;
+
+	if (nullmap)
+		memset(nullmap, 0, (nrows + 7) / 8);
+
+	for (i = 0; i < nrows; i++)
+	{
+		const char *p;
+
+		if (PQgetisnull(res, row + i, col))
+		{
+			if (nullmap)
+				nullmap[i >> 3] |= (uint8_t) (1 << (i & 7));
+			memset((char *) values + (size_t) i * len, 0, len);
+			continue;
+		}
+
+		if (PQgetlength(res, row + i, col) != len)
+			return -1;
+
+		p = PQgetvalue(res, row + i, col);
+
+		/* decode value in network order */
+		switch (len)
+		{
+		case 1:
+			((uint8_t *) values)[i] = *((uint8_t *) p);
+			break;
+		case 2:
+			((uint16_t *) values)[i] = BYTESWAP2(*((uint16_t *) p));
+			break;
+		case 4:
+			((uint32_t *) values)[i] = BYTESWAP4(*((uint32_t *) p));
+			break;
+		case 8:
+			((uint64_t *) values)[i] = BYTESWAP8(*((uint64_t *) p));
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	return nrows;
+}
+
+/*
+ * oid 16: bool
+ */
+DECLSPEC int
+pqbf_decode_column_bool(const PGresult *res, int col, int row, int nrows, uint8_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(uint8_t), values, nullmap);
+}
+
+/*
+ * oid 21: int2
+ */
+DECLSPEC int
+pqbf_decode_column_int2(const PGresult *res, int col, int row, int nrows, int16_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(int16_t), values, nullmap);
+}
+
+/*
+ * oid 23: int4
+ */
+DECLSPEC int
+pqbf_decode_column_int4(const PGresult *res, int col, int row, int nrows, int32_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(int32_t), values, nullmap);
+}
+
+/*
+ * oid 20: int8
+ */
+DECLSPEC int
+pqbf_decode_column_int8(const PGresult *res, int col, int row, int nrows, int64_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(int64_t), values, nullmap);
+}
+
+/*
+ * oid 700: float4
+ */
+DECLSPEC int
+pqbf_decode_column_float4(const PGresult *res, int col, int row, int nrows, float *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(float), values, nullmap);
+}
+
+/*
+ * oid 701: float8
+ */
+DECLSPEC int
+pqbf_decode_column_float8(const PGresult *res, int col, int row, int nrows, double *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(double), values, nullmap);
+}
+
+/*
+ * oid 1114: timestamp
+ * oid 1184: timestamptz
+ *
+ * values are microseconds since 2000-01-01, INT64_MIN and INT64_MAX encode -infinity and infinity
+ */
+DECLSPEC int
+pqbf_decode_column_timestamp(const PGresult *res, int col, int row, int nrows, int64_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(int64_t), values, nullmap);
+}
+
+/*
+ * oid 1082: date
+ *
+ * values are days since 2000-01-01, INT32_MIN and INT32_MAX encode -infinity and infinity
+ */
+DECLSPEC int
+pqbf_decode_column_date(const PGresult *res, int col, int row, int nrows, int32_t *values, uint8_t *nullmap)
+{
+	return pqbf_decode_column(res, col, row, nrows, sizeof(int32_t), values, nullmap);
+}
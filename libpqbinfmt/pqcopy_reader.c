@@ -0,0 +1,302 @@
+/**
+ * @file pqcopy_reader.c
+ * @brief frontend to PQgetCopyData() (COPY TO STDOUT BINARY)
+ * @copyright Copyright (c) 2015-2017, XIMES GmbH
+ * @see https://www.postgresql.org/docs/current/static/libpq-copy.html
+ * @see https://www.postgresql.org/docs/current/static/sql-copy.html#AEN77709
+ * @note postgresql source src/backend/commands/copyfromparse.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DLL_EXPORT
+#include "pqcopy_reader.h"
+#include "pqbincopy.h"
+#include "pqbinfmt.h"
+
+/* COPY header signature */
+static const char BinarySignature[11] = "PGCOPY\n\377\r\n\0";
+
+
+DECLSPEC pqcopy_reader *
+pqcr_create(PGconn *conn, int num_cols, int header_received)
+{
+	pqcopy_reader *r;
+
+	BAILWITHVALUEIFNULL(conn, NULL);
+
+	if (num_cols <= 0)
+	{
+		return NULL;
+	}
+
+	r = (pqcopy_reader *) malloc(sizeof(pqcopy_reader));
+
+	if (r)
+	{
+		r->conn = conn;
+		r->num_cols = num_cols;
+		r->header = header_received != 0;
+		r->eof = 0;
+		r->data = NULL;
+		r->len = 0;
+		r->pos = 0;
+	}
+
+	return r;
+}
+
+
+DECLSPEC void
+pqcr_free(pqcopy_reader *r)
+{
+	if (r)
+	{
+		if (r->data)
+			PQfreemem(r->data);
+		free(r);
+	}
+}
+
+
+static int32_t
+pqcr_read_int32(const char *p)
+{
+	uint32_t i;
+	memcpy(&i, p, sizeof(i));
+	return (int32_t) BYTESWAP4(i);
+}
+
+
+static int16_t
+pqcr_read_int16(const char *p)
+{
+	uint16_t i;
+	memcpy(&i, p, sizeof(i));
+	return (int16_t) BYTESWAP2(i);
+}
+
+
+/* receive next COPY data message, returns 1 on success, 0 at the end of COPY data, or an error code */
+static int
+pqcr_fetch(pqcopy_reader *r)
+{
+	int n;
+
+	if (r->data)
+	{
+		PQfreemem(r->data);
+		r->data = NULL;
+	}
+
+	r->len = 0;
+	r->pos = 0;
+
+	n = PQgetCopyData(r->conn, &r->data, 0);
+
+	if (n == -1)
+	{
+		/* end of COPY data */
+		r->eof = 1;
+		return 0;
+	}
+
+	if (n <= 0)
+	{
+		return PQCR_CONN;
+	}
+
+	r->len = n;
+
+	if (!r->header)
+	{
+		int32_t flags;
+		int32_t ext_len;
+
+		/* 11 byte signature, 32 bit flags, and 32 bit header extension length */
+		if (n < 19 || memcmp(r->data, BinarySignature, 11) != 0)
+			return PQCR_ERROR;
+
+		flags = pqcr_read_int32(r->data + 11);
+
+		/* tuples with oids are not supported */
+		if (flags & (1 << 16))
+			return PQCR_ERROR;
+
+		ext_len = pqcr_read_int32(r->data + 15);
+		if (ext_len < 0 || ext_len > n - 19)
+			return PQCR_ERROR;
+
+		r->pos = 19 + ext_len;
+		r->header = 1;
+	}
+
+	return 1;
+}
+
+
+/*
+ * decode up to nrows tuples into the column vectors cols, ncols must match
+ * the number of columns of the COPY data.
+ *
+ * returns the number of decoded rows, which is less than nrows in case the
+ * end of COPY data has been reached or the next tuple does not fit into the
+ * variable-length column buffers, or one of the PQCR_* error codes
+ */
+DECLSPEC int
+pqcr_get_rows(pqcopy_reader *r, pqcopy_vector *cols, int ncols, int nrows)
+{
+	int i;
+	int j;
+
+	BAILWITHVALUEIFNULL(r, PQCR_ERROR);
+	BAILWITHVALUEIFNULL(cols, PQCR_ERROR);
+
+	if (ncols != r->num_cols || nrows < 0)
+		return PQCR_ERROR;
+
+	for (j = 0; j < ncols; j++)
+	{
+		int typlen = pqcb_get_typlen(cols[j].oid);
+
+		if (typlen < 0 || (typlen == 0 && cols[j].lens == NULL) || (cols[j].values == NULL && (typlen > 0 || cols[j].cap > 0)))
+			return PQCR_ERROR;
+
+		cols[j].used = 0;
+
+		if (cols[j].nullmap)
+			memset(cols[j].nullmap, 0, (nrows + 7) / 8);
+	}
+
+	for (i = 0; i < nrows && !r->eof; )
+	{
+		const char *p;
+		const char *end;
+		int16_t field_count;
+
+		if (r->data == NULL || r->pos >= r->len)
+		{
+			int ret = pqcr_fetch(r);
+			if (ret == 0) break;
+			if (ret != 1) return ret;
+			continue; /* the header might be the only content of the first message */
+		}
+
+		p = r->data + r->pos;
+		end = r->data + r->len;
+
+		if (end - p < (ptrdiff_t) sizeof(field_count))
+			return PQCR_ERROR;
+
+		field_count = pqcr_read_int16(p);
+		p += sizeof(field_count);
+
+		if (field_count == -1)
+		{
+			/* file trailer, the next PQgetCopyData() must signal the end of COPY data */
+			int ret = pqcr_fetch(r);
+			if (ret == 1) return PQCR_ERROR;
+			if (ret != 0) return ret;
+			break;
+		}
+
+		if (field_count != r->num_cols)
+			return PQCR_ERROR;
+
+		/* check all fields of the tuple before we store anything */
+		{
+			const char *q = p;
+
+			for (j = 0; j < ncols; j++)
+			{
+				int typlen = pqcb_get_typlen(cols[j].oid);
+				int32_t flen;
+
+				if (end - q < (ptrdiff_t) sizeof(flen))
+					return PQCR_ERROR;
+
+				flen = pqcr_read_int32(q);
+				q += sizeof(flen);
+
+				if (flen == -1)
+					continue;
+
+				if (flen < 0 || end - q < flen || (typlen > 0 && flen != typlen))
+					return PQCR_ERROR;
+
+				if (typlen == 0 && cols[j].used + flen > cols[j].cap)
+				{
+					/* keep tuple for the next call */
+					if (i == 0)
+						return PQCR_TOOSMALL;
+					return i;
+				}
+
+				q += flen;
+			}
+		}
+
+		for (j = 0; j < ncols; j++)
+		{
+			pqcopy_vector *c = &cols[j];
+			int typlen = pqcb_get_typlen(c->oid);
+			int32_t flen = pqcr_read_int32(p);
+
+			p += sizeof(flen);
+
+			if (flen == -1)
+			{
+				if (c->nullmap)
+					c->nullmap[i >> 3] |= (uint8_t) (1 << (i & 7));
+
+				if (typlen == 0)
+					c->lens[i] = -1;
+				else
+					memset((char *) c->values + (size_t) i * typlen, 0, typlen);
+
+				continue;
+			}
+
+			switch (typlen)
+			{
+			case 0:
+				memcpy((char *) c->values + c->used, p, flen);
+				c->used += flen;
+				c->lens[i] = flen;
+				break;
+			case 1:
+				((uint8_t *) c->values)[i] = *((const uint8_t *) p);
+				break;
+			case 2:
+			{
+				uint16_t v;
+				memcpy(&v, p, sizeof(v));
+				((uint16_t *) c->values)[i] = BYTESWAP2(v);
+				break;
+			}
+			case 4:
+			{
+				uint32_t v;
+				memcpy(&v, p, sizeof(v));
+				((uint32_t *) c->values)[i] = BYTESWAP4(v);
+				break;
+			}
+			case 8:
+			{
+				uint64_t v;
+				memcpy(&v, p, sizeof(v));
+				((uint64_t *) c->values)[i] = BYTESWAP8(v);
+				break;
+			}
+			}
+
+			p += flen;
+		}
+
+		r->pos = (int) (p - r->data);
+		i++;
+	}
+
+	return i;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * @file pqcopy_reader.h
+ * @brief frontend to PQgetCopyData() (COPY TO STDOUT BINARY)
+ * @copyright Copyright (c) 2015-2017, XIMES GmbH
+ * @see https://www.postgresql.org/docs/current/static/libpq-copy.html
+ * @see https://www.postgresql.org/docs/current/static/sql-copy.html#AEN77709
+ */
+
+#ifndef __PQ_COPY_READER_H
+#define __PQ_COPY_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libpq-fe.h>
+
+#include "pqbinfmt_config.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* error codes of pqcr_get_rows() */
+#define PQCR_ERROR    -1 /* malformed COPY data or unexpected column type */
+#define PQCR_CONN     -2 /* PQgetCopyData() failed */
+#define PQCR_TOOSMALL -3 /* next tuple does not fit into the variable-length column buffers */
+
+/*
+ * column vector for pqcr_get_rows()
+ *
+ * fixed-length types receive their values in host byte order in values, one
+ * item per row, NULL values are stored as 0.  Variable-length types (bytea and
+ * character types) receive the raw bytes of all non-NULL rows back to back in
+ * values, which has room for cap bytes, and the byte length of each row in
+ * lens, lens[i] = -1 denotes NULL.  If nullmap is not NULL, bit i of nullmap
+ * (LSB first) is set iff row i is NULL.
+ */
+typedef struct pqcopy_vector
+{
+	uint32_t oid;      /* type oid of the source column */
+	void *values;      /* column values */
+	int32_t *lens;     /* row lengths of variable-length values, NULL for fixed-length types */
+	uint8_t *nullmap;  /* NULL bitmap */
+	size_t cap;        /* size of values in bytes for variable-length types */
+	size_t used;       /* number of bytes stored in values for variable-length types */
+} pqcopy_vector;
+
+/*
+ * data structure encapsulating the COPY TO reader
+ */
+typedef struct pqcopy_reader
+{
+	PGconn *conn;      /* connection for receiving COPY data */
+	int num_cols;      /* number of columns for each tuple (fixed) */
+	int header;        /* COPY header has been read */
+	int eof;           /* file trailer or end of COPY data has been received */
+	char *data;        /* current COPY data message, allocated by libpq */
+	int len;           /* length of data */
+	int pos;           /* position of next tuple in data */
+} pqcopy_reader;
+
+
+extern DECLSPEC pqcopy_reader *pqcr_create(PGconn *conn, int num_cols, int header_received);
+extern DECLSPEC void pqcr_free(pqcopy_reader *r);
+
+extern DECLSPEC int pqcr_get_rows(pqcopy_reader *r, pqcopy_vector *cols, int ncols, int nrows);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __PQ_COPY_READER_H */
\ No newline at end of file
@@ -20,6 +20,13 @@ extern "C" {
 #endif
 
 
+/* initial number of parameters */
+#define PQPB_MIN_CAPACITY 8
+
+/* payload buffers above this size are released in pqpb_reset() */
+#define PQPB_MAX_RETAINED_PAYLOAD (1024 * 1024)
+
+
 DECLSPEC pqparam_buffer *
 pqpb_create(void)
 {
@@ -40,6 +47,8 @@ pqpb_create(void)
 		b->param_len = NULL;
 		b->param_fmt = NULL;
 		b->param_vals = NULL;
+		b->capacity = 0;
+		b->vals_fixed = 0;
 	}
 
 	return b;
@@ -64,63 +73,105 @@ pqpb_free(pqparam_buffer *b)
 	}
 }
 
+/*
+ * remove all parameters, but keep the allocated parameter arrays and
+ * payload buffer for the next round of pqpb_add()
+ */
 DECLSPEC void
 pqpb_reset(pqparam_buffer *b)
 {
 	if (b)
 	{
 		b->num_param = 0;
-		resetPQExpBuffer(b->payload);
+		b->vals_fixed = 0;
 
-		XFREE(b->param_typ);
-		XFREE(b->param_dif);
-		XFREE(b->param_len);
-		XFREE(b->param_fmt);
-		XFREE(b->param_vals);
+		if (b->payload->maxlen > PQPB_MAX_RETAINED_PAYLOAD)
+		{
+			/* don't hold on to huge payloads */
+			PQExpBuffer payload = createPQExpBuffer();
+			if (payload)
+			{
+				destroyPQExpBuffer(b->payload);
+				b->payload = payload;
+			}
+		}
+
+		resetPQExpBuffer(b->payload);
 	}
 }
 
 
 #define REMALLOC(type, ptr, n, ret) \
 	do { \
-		if (ptr) { \
-			type *newptr = (type*) realloc(ptr, (n + 1) * sizeof(type)); \
-			if (newptr != NULL) { \
-				ptr = newptr ; \
-			} else { \
-				ret = -1; \
-			} \
-		}	else { \
-			ptr = (type*) malloc(sizeof(type)); \
+		type *newptr = (type*) realloc(ptr, (n) * sizeof(type)); \
+		if (newptr != NULL) { \
+			ptr = newptr; \
+		} else { \
+			ret = -1; \
 		} } while(0)
 
 
-void
-pqpb_add(pqparam_buffer *b, Oid typ, size_t len)
+/*
+ * make room for at least n parameters and payload_bytes additional bytes
+ * of parameter values, returns 0 on success and -1 on failure
+ */
+DECLSPEC int
+pqpb_reserve(pqparam_buffer *b, size_t n, size_t payload_bytes)
 {
 	int ret = 0;
 
+	BAILWITHVALUEIFNULL(b, -1);
+
+	/* param_vals may already point into the payload */
+	if (b->vals_fixed)
+		return -1;
+
+	if (n > b->capacity)
+	{
+		/* grow geometrically */
+		size_t capacity = b->capacity < PQPB_MIN_CAPACITY ? PQPB_MIN_CAPACITY : b->capacity;
+
+		while (capacity < n)
+			capacity *= 2;
+
+		REMALLOC(Oid, b->param_typ, capacity, ret);
+		REMALLOC(ptrdiff_t, b->param_dif, capacity, ret);
+		REMALLOC(int, b->param_len, capacity, ret);
+		REMALLOC(int, b->param_fmt, capacity, ret);
+		REMALLOC(char*, b->param_vals, capacity, ret);
+
+		if (ret == -1)
+			return -1;
+
+		b->capacity = capacity;
+	}
+
+	if (payload_bytes > 0 && enlargePQExpBuffer(b->payload, payload_bytes) == 0)
+		return -1;
+
+	return 0;
+}
+
+
+void
+pqpb_add(pqparam_buffer *b, Oid typ, size_t len)
+{
 	/* bail out in case param_vals is fixed */
-	if (b->param_vals != NULL)
+	if (b->vals_fixed)
+		return;
+
+	if (b->num_param == b->capacity && pqpb_reserve(b, b->num_param + 1, 0) == -1)
 		return;
 
 	/* OID of type */
-	REMALLOC(Oid, b->param_typ, b->num_param, ret);
-	if (b->param_typ == NULL || ret == -1) return;
 	b->param_typ[b->num_param] = typ;
-	
+
 	/* byte offset from b->payload->data to start of parameter value */
-	REMALLOC(ptrdiff_t, b->param_dif, b->num_param, ret);
-	if (b->param_dif == NULL || ret == -1) return;
 	b->param_dif[b->num_param] = b->payload->len - len;
 
 	/* data length */
-	REMALLOC(int, b->param_len, b->num_param, ret);
-	if (b->param_len == NULL || ret == -1) return;
 	b->param_len[b->num_param] = len;
 
-	REMALLOC(int, b->param_fmt, b->num_param, ret);
-	if (b->param_fmt == NULL || ret == -1) return;
 	b->param_fmt[b->num_param] = 1; /* binary format */
 
 	b->num_param++;
@@ -140,7 +191,7 @@ pqpb_get_num(pqparam_buffer *b)
 DECLSPEC Oid *
 pqpb_get_types(pqparam_buffer *b)
 {
-	if (b)
+	if (b && b->num_param > 0)
 	{
 		return b->param_typ;
 	}
@@ -151,15 +202,11 @@ pqpb_get_types(pqparam_buffer *b)
 DECLSPEC char **
 pqpb_get_vals(pqparam_buffer *b)
 {
-	if (b)
+	if (b && b->num_param > 0)
 	{
-		if (b->param_vals == NULL && b->num_param > 0)
+		if (!b->vals_fixed)
 		{
 			int i;
-			b->param_vals = (char**) malloc(b->num_param * sizeof(char*));
-
-			if (b->param_vals == NULL)
-				return NULL;
 
 			/* set parameter value start to difference from start of payload data
 			 * we can only do this after PQExpBuffer is fixed, i.e., no realloc()
@@ -176,6 +223,8 @@ pqpb_get_vals(pqparam_buffer *b)
 					b->param_vals[i] = NULL; // NULL value
 				}
 			}
+
+			b->vals_fixed = 1;
 		}
 
 		return b->param_vals;
@@ -187,7 +236,7 @@ pqpb_get_vals(pqparam_buffer *b)
 DECLSPEC int *
 pqpb_get_lens(pqparam_buffer *b)
 {
-	if (b)
+	if (b && b->num_param > 0)
 	{
 		return b->param_len;
 	}
@@ -198,7 +247,7 @@ pqpb_get_lens(pqparam_buffer *b)
 DECLSPEC int *
 pqpb_get_frms(pqparam_buffer *b)
 {
-	if (b)
+	if (b && b->num_param > 0)
 	{
 		return b->param_fmt;
 	}
@@ -40,11 +40,14 @@ typedef struct pqparam_buffer
 	int   *param_len;
 	int   *param_fmt;
 	char **param_vals;
+	size_t capacity; /* number of allocated items in param_typ, param_dif, param_len, param_fmt, and param_vals */
+	int vals_fixed; /* param_vals are set up, no more parameters can be added until pqpb_reset() */
 } pqparam_buffer;
 
 extern DECLSPEC pqparam_buffer * pqpb_create(void);
 extern DECLSPEC void pqpb_free(pqparam_buffer *p);
 extern DECLSPEC void pqpb_reset(pqparam_buffer *p);
+extern DECLSPEC int pqpb_reserve(pqparam_buffer *p, size_t n, size_t payload_bytes);
 
 extern void pqpb_add(pqparam_buffer *buf, Oid typ, size_t len);
 
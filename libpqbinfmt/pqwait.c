@@ -0,0 +1,239 @@
+/**
+ * @file pqwait.c
+ * @brief wait for socket readiness of PGconn in non-blocking mode
+ * @copyright Copyright (c) 2015-2017, XIMES GmbH
+ * @see https://www.postgresql.org/docs/current/static/libpq-async.html
+ */
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#endif /* _WIN32 */
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#define PQSW_EPOLL
+#endif /* __linux__ */
+
+#define DLL_EXPORT
+#include "pqwait.h"
+
+
+/*
+ * wait at most timeout milliseconds (-1 waits forever) until the socket of
+ * conn is ready for events (PQSW_READ and/or PQSW_WRITE).
+ *
+ * returns the ready events, 0 on timeout or interrupt, and -1 on failure
+ */
+DECLSPEC int
+pqsw_wait(PGconn *conn, int events, int timeout)
+{
+	int sock;
+	int ret;
+	int ready = 0;
+
+	BAILWITHVALUEIFNULL(conn, -1);
+
+	sock = PQsocket(conn);
+	if (sock < 0)
+		return -1;
+
+#ifdef _WIN32
+	{
+		WSAPOLLFD pfd;
+
+		pfd.fd = (SOCKET) sock;
+		pfd.events = 0;
+		pfd.revents = 0;
+
+		if (events & PQSW_READ) pfd.events |= POLLRDNORM;
+		if (events & PQSW_WRITE) pfd.events |= POLLWRNORM;
+
+		ret = WSAPoll(&pfd, 1, timeout);
+
+		if (ret == SOCKET_ERROR)
+			return -1;
+
+		/* report errors and hangups as ready, the next libpq call will notice */
+		if (pfd.revents & (POLLRDNORM | POLLERR | POLLHUP)) ready |= events & PQSW_READ;
+		if (pfd.revents & (POLLWRNORM | POLLERR | POLLHUP)) ready |= events & PQSW_WRITE;
+	}
+#else
+	{
+		struct pollfd pfd;
+
+		pfd.fd = sock;
+		pfd.events = 0;
+		pfd.revents = 0;
+
+		if (events & PQSW_READ) pfd.events |= POLLIN;
+		if (events & PQSW_WRITE) pfd.events |= POLLOUT;
+
+		ret = poll(&pfd, 1, timeout);
+
+		if (ret < 0)
+			return errno == EINTR ? 0 : -1;
+
+		/* report errors and hangups as ready, the next libpq call will notice */
+		if (pfd.revents & (POLLIN | POLLERR | POLLHUP)) ready |= events & PQSW_READ;
+		if (pfd.revents & (POLLOUT | POLLERR | POLLHUP)) ready |= events & PQSW_WRITE;
+	}
+#endif /* _WIN32 */
+
+	return ready;
+}
+
+
+#ifdef PQSW_EPOLL
+
+/* max number of events reported by one epoll_wait() call */
+#define PQSW_MAX_EVENTS 64
+
+struct pqwait_set
+{
+	int epfd;  /* epoll instance with one-shot registrations */
+};
+
+
+DECLSPEC pqwait_set *
+pqsw_create(void)
+{
+	pqwait_set *ws;
+
+	ws = (pqwait_set *) malloc(sizeof(pqwait_set));
+
+	if (ws)
+	{
+		ws->epfd = epoll_create1(EPOLL_CLOEXEC);
+
+		if (ws->epfd < 0)
+		{
+			free(ws);
+			ws = NULL;
+		}
+	}
+
+	return ws;
+}
+
+
+DECLSPEC void
+pqsw_free(pqwait_set *ws)
+{
+	if (ws)
+	{
+		close(ws->epfd);
+		free(ws);
+	}
+}
+
+
+/*
+ * register the socket of conn once for events (PQSW_READ and/or PQSW_WRITE).
+ * A former registration of the socket is replaced.
+ *
+ * returns 0 on success and -1 on failure
+ */
+DECLSPEC int
+pqsw_add(pqwait_set *ws, PGconn *conn, int events, int64_t token)
+{
+	int sock;
+	struct epoll_event ev;
+
+	BAILWITHVALUEIFNULL(ws, -1);
+	BAILWITHVALUEIFNULL(conn, -1);
+
+	sock = PQsocket(conn);
+	if (sock < 0)
+		return -1;
+
+	ev.events = EPOLLONESHOT;
+	if (events & PQSW_READ) ev.events |= EPOLLIN;
+	if (events & PQSW_WRITE) ev.events |= EPOLLOUT;
+	ev.data.u64 = (uint64_t) token;
+
+	/* sockets stay in the epoll set until they are closed, rearm them */
+	if (epoll_ctl(ws->epfd, EPOLL_CTL_MOD, sock, &ev) == 0)
+		return 0;
+
+	if (errno == ENOENT && epoll_ctl(ws->epfd, EPOLL_CTL_ADD, sock, &ev) == 0)
+		return 0;
+
+	return -1;
+}
+
+
+/*
+ * wait at most timeout milliseconds (-1 waits forever) until registered
+ * sockets are ready.  Stores the tokens of at most max ready registrations
+ * in tokens.
+ *
+ * returns the number of tokens, 0 on timeout or interrupt, and -1 on failure
+ */
+DECLSPEC int
+pqsw_wait_any(pqwait_set *ws, int64_t *tokens, int max, int timeout)
+{
+	struct epoll_event evs[PQSW_MAX_EVENTS];
+	int n;
+	int i;
+
+	BAILWITHVALUEIFNULL(ws, -1);
+	BAILWITHVALUEIFNULL(tokens, -1);
+
+	if (max <= 0)
+		return -1;
+
+	if (max > PQSW_MAX_EVENTS)
+		max = PQSW_MAX_EVENTS;
+
+	n = epoll_wait(ws->epfd, evs, max, timeout);
+
+	if (n < 0)
+		return errno == EINTR ? 0 : -1;
+
+	for (i = 0; i < n; i++)
+	{
+		tokens[i] = (int64_t) evs[i].data.u64;
+	}
+
+	return n;
+}
+
+
+#else
+
+DECLSPEC pqwait_set *
+pqsw_create(void)
+{
+	return NULL; /* callers fall back to pqsw_wait() */
+}
+
+
+DECLSPEC void
+pqsw_free(pqwait_set *ws)
+{
+	(void) ws;
+}
+
+
+DECLSPEC int
+pqsw_add(pqwait_set *ws, PGconn *conn, int events, int64_t token)
+{
+	(void) ws; (void) conn; (void) events; (void) token;
+	return -1;
+}
+
+
+DECLSPEC int
+pqsw_wait_any(pqwait_set *ws, int64_t *tokens, int max, int timeout)
+{
+	(void) ws; (void) tokens; (void) max; (void) timeout;
+	return -1;
+}
+
+
+#endif /* PQSW_EPOLL */
\ No newline at end of file
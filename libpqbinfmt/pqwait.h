@@ -0,0 +1,44 @@
+/**
+ * @file pqwait.h
+ * @brief wait for socket readiness of PGconn in non-blocking mode
+ * @copyright Copyright (c) 2015-2017, XIMES GmbH
+ * @see https://www.postgresql.org/docs/current/static/libpq-async.html
+ */
+
+#ifndef __PQ_WAIT_H
+#define __PQ_WAIT_H
+
+#include <stdint.h>
+#include <libpq-fe.h>
+
+#include "pqbinfmt_config.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* events for pqsw_wait() */
+#define PQSW_READ  1
+#define PQSW_WRITE 2
+
+extern DECLSPEC int pqsw_wait(PGconn *conn, int events, int timeout);
+
+/*
+ * set of one-shot socket registrations: a single thread waits in
+ * pqsw_wait_any() on the sockets of many PGconn, each registration is
+ * reported once with the token given to pqsw_add().  Only available with
+ * epoll (Linux), pqsw_create() returns NULL on other platforms.
+ */
+typedef struct pqwait_set pqwait_set;
+
+extern DECLSPEC pqwait_set *pqsw_create(void);
+extern DECLSPEC void pqsw_free(pqwait_set *ws);
+
+extern DECLSPEC int pqsw_add(pqwait_set *ws, PGconn *conn, int events, int64_t token);
+extern DECLSPEC int pqsw_wait_any(pqwait_set *ws, int64_t *tokens, int max, int timeout);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __PQ_WAIT_H */
\ No newline at end of file